@@ -0,0 +1,289 @@
+#include <AssetLoader.h>
+#include <GLStateCache.h>
+#include <Texture.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    // Decoding a few sticker images doesn't need more, and the simulation keeps its cores
+    const unsigned int DefaultThreadCount = 2;
+}
+
+AssetLoader::AssetLoader(unsigned int threadCount, size_t uploadBudget)
+    : m_Quit(false), m_UploadBudget(std::max<size_t>(uploadBudget, 1)), m_UploadedBytes(0)
+{
+    unsigned int threads = threadCount > 0 ? threadCount : DefaultThreadCount;
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        m_Workers.emplace_back(&AssetLoader::WorkerMain, this);
+    }
+}
+
+AssetLoader::~AssetLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Quit = true;
+    }
+    m_JobReady.notify_all();
+    for (std::thread& worker : m_Workers)
+    {
+        worker.join();
+    }
+
+    // Textures that outlive the loader keep their placeholder
+    for (const std::shared_ptr<Request>& request : m_Uploads)
+    {
+        if (request->staging != 0)
+        {
+            GLStateCache::ForgetTexture(request->staging);
+            GLCall(glDeleteTextures(1, &request->staging));
+        }
+        if (request->texture)
+        {
+            request->texture->m_Loader = nullptr;
+        }
+    }
+    for (const std::shared_ptr<Request>& request : m_Decoded)
+    {
+        if (request->texture)
+        {
+            request->texture->m_Loader = nullptr;
+        }
+    }
+    for (const std::shared_ptr<Request>& request : m_Decoding)
+    {
+        if (request->texture)
+        {
+            request->texture->m_Loader = nullptr;
+        }
+    }
+}
+
+void AssetLoader::Load(Texture& texture, const std::vector<std::string>& filepaths, int channels)
+{
+    auto request = std::make_shared<Request>();
+    request->texture = &texture;
+    request->filepaths = filepaths;
+    request->channels = channels;
+    request->images.resize(filepaths.size());
+    request->pendingLayers = filepaths.size();
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (filepaths.empty())
+        {
+            // Nothing to decode, the upload leaves the white texel
+            m_Decoded.push_back(request);
+            return;
+        }
+        m_Decoding.push_back(request);
+        for (size_t layer = 0; layer < filepaths.size(); ++layer)
+        {
+            m_Jobs.push_back({ request, layer });
+        }
+    }
+    m_JobReady.notify_all();
+}
+
+void AssetLoader::Cancel(Texture& texture)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        // Layers already being decoded finish, then get dropped by their worker
+        for (auto it = m_Jobs.begin(); it != m_Jobs.end();)
+        {
+            if (it->request->texture != &texture)
+            {
+                ++it;
+                continue;
+            }
+            if (--it->request->pendingLayers == 0)
+            {
+                m_Decoding.erase(std::find(m_Decoding.begin(), m_Decoding.end(), it->request));
+            }
+            it = m_Jobs.erase(it);
+        }
+        for (const std::shared_ptr<Request>& request : m_Decoding)
+        {
+            if (request->texture == &texture)
+            {
+                request->texture = nullptr;
+            }
+        }
+        for (const std::shared_ptr<Request>& request : m_Decoded)
+        {
+            if (request->texture == &texture)
+            {
+                request->texture = nullptr;
+            }
+        }
+        m_Decoded.erase(std::remove_if(m_Decoded.begin(), m_Decoded.end(),
+            [](const std::shared_ptr<Request>& request) { return request->texture == nullptr; }), m_Decoded.end());
+    }
+    m_Progress.notify_all();
+
+    for (auto it = m_Uploads.begin(); it != m_Uploads.end();)
+    {
+        Request& request = **it;
+        if (request.texture != &texture)
+        {
+            ++it;
+            continue;
+        }
+        if (request.staging != 0)
+        {
+            GLStateCache::ForgetTexture(request.staging);
+            GLCall(glDeleteTextures(1, &request.staging));
+        }
+        it = m_Uploads.erase(it);
+    }
+    texture.m_Loader = nullptr;
+}
+
+void AssetLoader::Update()
+{
+    Upload(m_UploadBudget);
+}
+
+void AssetLoader::Finish()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Progress.wait(lock, [this] { return m_Decoding.empty(); });
+    }
+    Upload(std::numeric_limits<size_t>::max());
+}
+
+bool AssetLoader::IsIdle()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Decoding.empty() && m_Decoded.empty() && m_Uploads.empty();
+}
+
+void AssetLoader::WorkerMain()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_JobReady.wait(lock, [this] { return m_Quit || !m_Jobs.empty(); });
+            if (m_Quit)
+            {
+                return;
+            }
+            job = std::move(m_Jobs.front());
+            m_Jobs.pop_front();
+        }
+
+        // Every layer has its own image, so workers never write the same one
+        Request& request = *job.request;
+        TextureImage::Load(request.filepaths[job.layer], request.images[job.layer], request.channels);
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (--request.pendingLayers == 0)
+            {
+                m_Decoding.erase(std::find(m_Decoding.begin(), m_Decoding.end(), job.request));
+                if (request.texture)
+                {
+                    m_Decoded.push_back(job.request);
+                }
+            }
+        }
+        m_Progress.notify_all();
+    }
+}
+
+void AssetLoader::Upload(size_t budget)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Uploads.insert(m_Uploads.end(), m_Decoded.begin(), m_Decoded.end());
+        m_Decoded.clear();
+    }
+    if (m_Uploads.empty())
+    {
+        return;
+    }
+
+    while (!m_Uploads.empty() && budget > 0 && UploadRows(*m_Uploads.front(), budget))
+    {
+        m_Uploads.pop_front();
+    }
+
+    // Left bound, the unpack buffer would turn every other texture upload's pointer into an offset
+    GLStateCache::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    GLStateCache::BindTexture(0, GL_TEXTURE_2D, 0);
+    GLStateCache::BindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+}
+
+bool AssetLoader::UploadRows(Request& request, size_t& budget)
+{
+    Texture& texture = *request.texture;
+    unsigned int target = texture.GetTarget();
+    if (request.staging == 0)
+    {
+        Texture::MatchLayers(request.filepaths, request.images);
+        request.staging = Texture::Allocate(target, request.images.front(), static_cast<int>(request.images.size()));
+    }
+    else
+    {
+        GLStateCache::BindTexture(0, target, request.staging);
+    }
+
+    if (!m_UnpackBuffer)
+    {
+        m_UnpackBuffer = std::make_unique<StreamBuffer>(GL_PIXEL_UNPACK_BUFFER, m_UploadBudget);
+    }
+
+    const TextureImage& first = request.images.front();
+    int layers = static_cast<int>(request.images.size());
+    while (request.layer < request.images.size())
+    {
+        if (budget == 0)
+        {
+            return false;
+        }
+
+        const TextureImage& image = request.images[request.layer];
+        const TextureImage::Level& mip = image.levels[request.level];
+        int rowCount = (mip.height + image.GetRowHeight() - 1) / image.GetRowHeight();
+        size_t rowBytes = image.GetRowBytes(static_cast<int>(request.level));
+        int rows = static_cast<int>(std::clamp<size_t>(budget / rowBytes, 1, static_cast<size_t>(rowCount - request.row)));
+        size_t offset = request.row * rowBytes;
+        size_t size = rows * rowBytes;
+        budget -= std::min(budget, size);
+
+        // TextureImage::Load only accepts levels holding every row, so this stays inside mip.data
+        void* mapped = m_UnpackBuffer->Map(size);
+        std::memcpy(mapped, mip.data.data() + offset, size);
+        m_UnpackBuffer->Unmap();
+        m_UnpackBuffer->Bind();
+        Texture::UploadRows(target, image, static_cast<int>(request.level), static_cast<int>(request.layer), request.row, rows,
+            reinterpret_cast<const void*>(m_UnpackBuffer->GetOffset()));
+        m_UnpackBuffer->Fence();
+        m_UploadedBytes += size;
+
+        request.row += rows;
+        if (request.row == rowCount)
+        {
+            request.row = 0;
+            if (++request.level == image.levels.size())
+            {
+                request.level = 0;
+                request.layer++;
+            }
+        }
+    }
+
+    Texture::FinishMipmaps(target, first);
+    texture.Adopt(request.staging, first, layers);
+    texture.m_Loader = nullptr;
+    request.staging = 0;
+    return true;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <StreamBuffer.h>
+#include <TextureImage.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Texture;
+
+// Streams texture files in without stalling the render thread.
+// Worker threads read and decode the files; once every layer of a texture is decoded it is handed
+// back through a queue, and Update() on the GL thread copies a bounded number of bytes per frame
+// into a pixel unpack buffer and on into a staging texture. The staging texture replaces the
+// texture's placeholder only when it is complete, so a draw never samples a half-uploaded image.
+class AssetLoader
+{
+    public:
+        // Bytes uploaded per Update(); at least one row of texels always goes through
+        static constexpr size_t DefaultUploadBudget = 4 << 20;
+    private:
+        struct Request
+        {
+            Texture* texture;  // Null once the texture is gone
+            std::vector<std::string> filepaths;
+            int channels;
+            std::vector<TextureImage> images;  // One per file, each written by the worker that decodes it
+            size_t pendingLayers;
+
+            // Upload progress, only touched on the GL thread
+            unsigned int staging = 0;
+            size_t layer = 0;
+            size_t level = 0;
+            int row = 0;
+        };
+
+        struct Job
+        {
+            std::shared_ptr<Request> request;
+            size_t layer;
+        };
+
+        std::vector<std::thread> m_Workers;
+        std::mutex m_Mutex;
+        std::condition_variable m_JobReady;
+        std::condition_variable m_Progress;
+        std::deque<Job> m_Jobs;
+        std::vector<std::shared_ptr<Request>> m_Decoded;
+        std::vector<std::shared_ptr<Request>> m_Decoding;  // Layers still queued or being decoded
+        bool m_Quit;
+
+        // GL thread only
+        std::deque<std::shared_ptr<Request>> m_Uploads;
+        std::unique_ptr<StreamBuffer> m_UnpackBuffer;
+        size_t m_UploadBudget;
+        size_t m_UploadedBytes;
+    public:
+        // 'threadCount' 0 picks a small pool that leaves the simulation workers alone
+        AssetLoader(unsigned int threadCount = 0, size_t uploadBudget = DefaultUploadBudget);
+        ~AssetLoader();
+
+        AssetLoader(const AssetLoader&) = delete;
+        AssetLoader& operator=(const AssetLoader&) = delete;
+
+        // Call once per frame on the GL thread
+        void Update();
+        // Blocks until everything requested so far is decoded and uploaded, e.g. before a replay
+        void Finish();
+
+        bool IsIdle();
+        // Bytes copied to textures so far
+        inline size_t GetUploadedBytes() const { return m_UploadedBytes; }
+    private:
+        friend class Texture;
+
+        // Called by Texture's streaming constructor and destructor, on the GL thread
+        void Load(Texture& texture, const std::vector<std::string>& filepaths, int channels);
+        void Cancel(Texture& texture);
+
+        void WorkerMain();
+        void Upload(size_t budget);
+        // Returns true once the request's texture is complete
+        bool UploadRows(Request& request, size_t& budget);
+};
@@ -49,7 +49,15 @@ void Camera::Zoom(float delta)
 {
     const float zoomSpeed = 0.5f;
     m_Distance -= static_cast<float>(delta) * zoomSpeed;
-    m_Distance = glm::clamp(m_Distance, 2.0f, 25.0f);
+    m_Distance = glm::clamp(m_Distance, m_MinDistance, m_MaxDistance);
+    UpdateView();
+}
+
+void Camera::SetDistance(float distance, float minDistance, float maxDistance)
+{
+    m_MinDistance = minDistance;
+    m_MaxDistance = maxDistance;
+    m_Distance = glm::clamp(distance, m_MinDistance, m_MaxDistance);
     UpdateView();
 }
 
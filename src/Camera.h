@@ -35,6 +35,8 @@ class Camera
 
         // Orbit/pan camera parameters
         float m_Distance = 6.0f;
+        float m_MinDistance = 2.0f;
+        float m_MaxDistance = 25.0f;
         float m_YawDeg = 0.0f;
         float m_PitchDeg = 0.0f;
         glm::vec3 m_PanOffset = glm::vec3(0.0f);
@@ -61,6 +63,8 @@ class Camera
         void RotateOrbit(float deltaX, float deltaY);
         void Pan(float deltaX, float deltaY);
         void Zoom(float delta);
+        // Orbit distance from the target, clamped to [minDistance, maxDistance] by Zoom()
+        void SetDistance(float distance, float minDistance, float maxDistance);
 
         glm::vec3 GetRight() const;
         glm::vec3 GetUp() const;
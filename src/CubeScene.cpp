@@ -0,0 +1,259 @@
+#include <CubeScene.h>
+
+#include <MoveSequence.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace
+{
+    // Puzzles handed to a thread at a time; large enough to amortize the atomic, small enough to balance
+    const size_t ChunkSize = 8;
+}
+
+CubeScene::CubeScene(int puzzleCount, float spacing, unsigned int threadCount)
+    : m_Autoplay(false), m_NextIndex(0), m_Generation(0), m_ActiveWorkers(0), m_Quit(false)
+{
+    int count = std::max(puzzleCount, 1);
+    int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+    float half = 0.5f * static_cast<float>(side - 1);
+
+    m_Puzzles.resize(count);
+    for (int i = 0; i < count; ++i)
+    {
+        Puzzle& puzzle = m_Puzzles[i];
+        puzzle.cube = std::make_unique<RubiksCube>(spacing);
+        puzzle.cube->Initialize();
+
+        // Row-major from the top left, centered on the origin
+        float x = (static_cast<float>(i % side) - half) * PuzzlePitch;
+        float y = (half - static_cast<float>(i / side)) * PuzzlePitch;
+        puzzle.placement = glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f));
+    }
+
+    // The calling thread takes part in every job, so it counts as one of the threads
+    unsigned int threads = threadCount > 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+    threads = std::min(threads, static_cast<unsigned int>((count + ChunkSize - 1) / ChunkSize));
+    for (unsigned int i = 1; i < threads; ++i)
+    {
+        m_Workers.emplace_back(&CubeScene::WorkerMain, this);
+    }
+}
+
+CubeScene::~CubeScene()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Quit = true;
+    }
+    m_WorkReady.notify_all();
+    for (std::thread& worker : m_Workers)
+    {
+        worker.join();
+    }
+}
+
+void CubeScene::EnableAutoplay(uint32_t seed)
+{
+    m_Autoplay = true;
+    for (size_t i = 0; i < m_Puzzles.size(); ++i)
+    {
+        std::seed_seq sequence = { seed, static_cast<uint32_t>(i) };
+        m_Puzzles[i].random.seed(sequence);
+    }
+}
+
+void CubeScene::Update(float deltaTime)
+{
+    ParallelFor([this, deltaTime](size_t index)
+    {
+        Puzzle& puzzle = m_Puzzles[index];
+        if (m_Autoplay)
+        {
+            AdvanceAutoplay(puzzle);
+        }
+        puzzle.cube->Update(deltaTime);
+    });
+}
+
+void CubeScene::SetAnimationSpeed(float degreesPerSecond)
+{
+    for (Puzzle& puzzle : m_Puzzles)
+    {
+        puzzle.cube->SetAnimationSpeed(degreesPerSecond);
+    }
+}
+
+void CubeScene::SetAnimationMode(RubiksCube::AnimationMode mode)
+{
+    for (Puzzle& puzzle : m_Puzzles)
+    {
+        puzzle.cube->SetAnimationMode(mode);
+    }
+}
+
+void CubeScene::PublishSnapshots(float alpha)
+{
+    ParallelFor([this, alpha](size_t index)
+    {
+        m_Puzzles[index].cube->PublishSnapshot(alpha);
+    });
+}
+
+void CubeScene::AcquireSnapshots()
+{
+    for (Puzzle& puzzle : m_Puzzles)
+    {
+        puzzle.cube->AcquireSnapshot();
+    }
+}
+
+bool CubeScene::IsIdle() const
+{
+    for (const Puzzle& puzzle : m_Puzzles)
+    {
+        if (puzzle.cube->IsRotating() || puzzle.cube->GetQueuedMoveCount() > 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t CubeScene::GetMinSolveCount() const
+{
+    uint32_t solves = m_Puzzles.front().solveCount;
+    for (const Puzzle& puzzle : m_Puzzles)
+    {
+        solves = std::min(solves, puzzle.solveCount);
+    }
+    return solves;
+}
+
+float CubeScene::GetExtent() const
+{
+    int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(m_Puzzles.size()))));
+    return 0.5f * static_cast<float>(side) * PuzzlePitch;
+}
+
+void CubeScene::ParallelFor(const std::function<void(size_t)>& job)
+{
+    if (m_Workers.empty())
+    {
+        for (size_t i = 0; i < m_Puzzles.size(); ++i)
+        {
+            job(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Job = job;
+        m_NextIndex.store(0);
+        m_ActiveWorkers = static_cast<unsigned int>(m_Workers.size());
+        ++m_Generation;
+    }
+    m_WorkReady.notify_all();
+
+    RunJob();
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_WorkDone.wait(lock, [this]() { return m_ActiveWorkers == 0; });
+    m_Job = nullptr;
+}
+
+void CubeScene::RunJob()
+{
+    size_t count = m_Puzzles.size();
+    while (true)
+    {
+        size_t first = m_NextIndex.fetch_add(ChunkSize);
+        if (first >= count)
+        {
+            return;
+        }
+        size_t last = std::min(first + ChunkSize, count);
+        for (size_t i = first; i < last; ++i)
+        {
+            m_Job(i);
+        }
+    }
+}
+
+void CubeScene::WorkerMain()
+{
+    uint64_t generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WorkReady.wait(lock, [this, generation]() { return m_Quit || m_Generation != generation; });
+            if (m_Quit)
+            {
+                return;
+            }
+            generation = m_Generation;
+        }
+
+        RunJob();
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (--m_ActiveWorkers == 0)
+        {
+            m_WorkDone.notify_one();
+        }
+    }
+}
+
+void CubeScene::AdvanceAutoplay(Puzzle& puzzle)
+{
+    if (puzzle.cube->IsRotating() || puzzle.cube->GetQueuedMoveCount() > 0)
+    {
+        return;
+    }
+
+    // The solve is queued only once the scramble has played, otherwise the queue would cancel them
+    if (!puzzle.solving && !puzzle.scramble.empty())
+    {
+        std::vector<CubeMove> solve(puzzle.scramble.rbegin(), puzzle.scramble.rend());
+        for (CubeMove& move : solve)
+        {
+            move.turns = -move.turns;
+        }
+        puzzle.cube->QueueMoves(solve);
+        puzzle.solving = true;
+        return;
+    }
+
+    if (puzzle.solving)
+    {
+        puzzle.solveCount++;
+        puzzle.solving = false;
+    }
+
+    // Canonical random face turns, so no move of the scramble cancels or merges with its neighbours.
+    // The engine's raw output is mapped by hand: std::uniform_int_distribution differs between standard
+    // libraries, which would give the same seed different scrambles. The bias of % over 18 values is negligible.
+    puzzle.scramble.clear();
+    int previous = -1;
+    std::array<int, MoveSequence::FaceMoveCount> candidates;
+    for (int i = 0; i < ScrambleLength; ++i)
+    {
+        uint32_t allowed = MoveSequence::AllowedAfter(previous);
+        size_t count = 0;
+        for (int move = 0; move < MoveSequence::FaceMoveCount; ++move)
+        {
+            if (allowed & (1u << move))
+            {
+                candidates[count++] = move;
+            }
+        }
+        previous = candidates[puzzle.random() % count];
+        puzzle.scramble.push_back(MoveSequence::FaceMove(previous));
+    }
+    puzzle.cube->QueueMoves(puzzle.scramble);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <RubiksCube.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Owns any number of independent puzzles laid out on a square grid in the XY plane.
+// Updates and snapshot publishing are split across a pool of worker threads; every puzzle is
+// touched by exactly one thread per call, so RubiksCube itself needs no locking.
+class CubeScene
+{
+    public:
+        // Distance between the centers of neighbouring puzzles
+        static constexpr float PuzzlePitch = 4.0f;
+        static constexpr int ScrambleLength = 20;
+    private:
+        struct Puzzle
+        {
+            std::unique_ptr<RubiksCube> cube;
+            glm::mat4 placement = glm::mat4(1.0f);
+            std::mt19937 random;
+            std::vector<CubeMove> scramble;
+            bool solving = false;
+            uint32_t solveCount = 0;
+        };
+
+        std::vector<Puzzle> m_Puzzles;
+        bool m_Autoplay;
+
+        // Worker pool: a job is a function over puzzle indices, handed out in chunks
+        std::vector<std::thread> m_Workers;
+        std::mutex m_Mutex;
+        std::condition_variable m_WorkReady;
+        std::condition_variable m_WorkDone;
+        std::function<void(size_t)> m_Job;
+        std::atomic<size_t> m_NextIndex;
+        uint64_t m_Generation;
+        unsigned int m_ActiveWorkers;
+        bool m_Quit;
+    public:
+        // 'threadCount' 0 uses every hardware thread; a single puzzle is always updated inline
+        CubeScene(int puzzleCount, float spacing = 1.06f, unsigned int threadCount = 0);
+        ~CubeScene();
+
+        CubeScene(const CubeScene&) = delete;
+        CubeScene& operator=(const CubeScene&) = delete;
+
+        // Every puzzle endlessly plays a scramble from its own seed followed by the moves that undo it
+        void EnableAutoplay(uint32_t seed);
+
+        void Update(float deltaTime);
+        void SetAnimationSpeed(float degreesPerSecond);
+        void SetAnimationMode(RubiksCube::AnimationMode mode);
+
+        // Same producer/consumer split as RubiksCube: publish from the simulation, acquire from the renderer
+        void PublishSnapshots(float alpha = 1.0f);
+        void AcquireSnapshots();
+
+        bool IsIdle() const;
+        // Smallest number of solves finished by any puzzle
+        uint32_t GetMinSolveCount() const;
+
+        inline int GetPuzzleCount() const { return static_cast<int>(m_Puzzles.size()); }
+        inline RubiksCube& GetPuzzle(int index) { return *m_Puzzles[index].cube; }
+        inline const RubiksCube& GetPuzzle(int index) const { return *m_Puzzles[index].cube; }
+        // A pure translation, so model-space bounding spheres keep their radius
+        inline const glm::mat4& GetPlacement(int index) const { return m_Puzzles[index].placement; }
+        // Half the width of the grid, for framing the whole scene
+        float GetExtent() const;
+    private:
+        void ParallelFor(const std::function<void(size_t)>& job);
+        void RunJob();
+        void WorkerMain();
+        void AdvanceAutoplay(Puzzle& puzzle);
+};
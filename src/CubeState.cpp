@@ -0,0 +1,340 @@
+#include <CubeState.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+    struct RotationTables
+    {
+        glm::mat3 matrices[CubeState::OrientationCount];
+        int codeToIndex[36];
+        int compose[CubeState::OrientationCount][CubeState::OrientationCount];
+        int inverse[CubeState::OrientationCount];
+        int turn[3][4];
+        uint8_t rotateSlot[CubeState::OrientationCount][CubeState::CubieCount];
+        uint64_t zobrist[CubeState::CubieCount][CubeState::CubieCount][CubeState::OrientationCount];
+    };
+
+    // Signed axis code of a (nearly) unit axis vector: 0..5 = +X, -X, +Y, -Y, +Z, -Z
+    int AxisCode(const glm::vec3& v)
+    {
+        int axis = 0;
+        for (int i = 1; i < 3; ++i)
+        {
+            if (std::fabs(v[i]) > std::fabs(v[axis]))
+            {
+                axis = i;
+            }
+        }
+        return axis * 2 + (v[axis] < 0.0f ? 1 : 0);
+    }
+
+    int MatrixCode(const glm::mat3& m)
+    {
+        return AxisCode(m[0]) * 6 + AxisCode(m[1]);
+    }
+
+    glm::mat3 QuarterTurn(int axis)
+    {
+        glm::vec3 axisVec(0.0f);
+        axisVec[axis] = 1.0f;
+        glm::mat3 m = glm::mat3(glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), axisVec));
+        for (int c = 0; c < 3; ++c)
+        {
+            for (int r = 0; r < 3; ++r)
+            {
+                m[c][r] = std::round(m[c][r]);
+            }
+        }
+        return m;
+    }
+
+    uint64_t SplitMix64(uint64_t& seed)
+    {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    RotationTables BuildTables()
+    {
+        RotationTables t;
+        for (int i = 0; i < 36; ++i)
+        {
+            t.codeToIndex[i] = -1;
+        }
+
+        // Breadth-first closure of the quarter turns about X, Y and Z gives the 24 cube rotations
+        int count = 0;
+        t.matrices[count] = glm::mat3(1.0f);
+        t.codeToIndex[MatrixCode(t.matrices[count])] = count;
+        ++count;
+        for (int i = 0; i < count; ++i)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                glm::mat3 next = QuarterTurn(axis) * t.matrices[i];
+                int code = MatrixCode(next);
+                if (t.codeToIndex[code] < 0)
+                {
+                    t.matrices[count] = next;
+                    t.codeToIndex[code] = count;
+                    ++count;
+                }
+            }
+        }
+
+        for (int a = 0; a < CubeState::OrientationCount; ++a)
+        {
+            for (int b = 0; b < CubeState::OrientationCount; ++b)
+            {
+                t.compose[a][b] = t.codeToIndex[MatrixCode(t.matrices[a] * t.matrices[b])];
+            }
+            t.inverse[a] = t.codeToIndex[MatrixCode(glm::transpose(t.matrices[a]))];
+            for (int slot = 0; slot < CubeState::CubieCount; ++slot)
+            {
+                glm::vec3 rotated = t.matrices[a] * glm::vec3(CubeState::SlotGrid(slot));
+                glm::ivec3 snapped(
+                    static_cast<int>(std::round(rotated.x)),
+                    static_cast<int>(std::round(rotated.y)),
+                    static_cast<int>(std::round(rotated.z))
+                );
+                t.rotateSlot[a][slot] = static_cast<uint8_t>(CubeState::SlotIndex(snapped));
+            }
+        }
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            glm::mat3 m(1.0f);
+            for (int q = 0; q < 4; ++q)
+            {
+                t.turn[axis][q] = t.codeToIndex[MatrixCode(m)];
+                m = QuarterTurn(axis) * m;
+            }
+        }
+
+        // Fixed seed so hashes are stable between runs (required by the on-disk caches)
+        uint64_t seed = 0x5275626978333333ull;
+        for (int cubie = 0; cubie < CubeState::CubieCount; ++cubie)
+        {
+            for (int slot = 0; slot < CubeState::CubieCount; ++slot)
+            {
+                for (int o = 0; o < CubeState::OrientationCount; ++o)
+                {
+                    t.zobrist[cubie][slot][o] = SplitMix64(seed);
+                }
+            }
+        }
+        return t;
+    }
+
+    const RotationTables& Tables()
+    {
+        static const RotationTables tables = BuildTables();
+        return tables;
+    }
+}
+
+CubeState::CubeState()
+    : m_Hash(0)
+{
+    for (int i = 0; i < CubieCount; ++i)
+    {
+        m_SlotOf[i] = static_cast<uint8_t>(i);
+        m_CubieAt[i] = static_cast<uint8_t>(i);
+        m_Orientation[i] = 0;
+    }
+    m_Hash = ComputeHash();
+}
+
+void CubeState::ApplyMove(const CubeMove& move)
+{
+    const RotationTables& t = Tables();
+    int rot = TurnOrientation(move.axis, move.turns);
+    if (rot == 0)
+    {
+        return;
+    }
+
+    // Gather the 9 slots of the layer first so the permutation can be written in place
+    uint8_t moved[9];
+    int movedCount = 0;
+    for (int a = -1; a <= 1; ++a)
+    {
+        for (int b = -1; b <= 1; ++b)
+        {
+            glm::ivec3 grid(0);
+            grid[move.axis] = move.layer;
+            grid[(move.axis + 1) % 3] = a;
+            grid[(move.axis + 2) % 3] = b;
+            moved[movedCount++] = m_CubieAt[SlotIndex(grid)];
+        }
+    }
+
+    for (int i = 0; i < movedCount; ++i)
+    {
+        int cubie = moved[i];
+        int slot = m_SlotOf[cubie];
+        int orientation = m_Orientation[cubie];
+        int newSlot = t.rotateSlot[rot][slot];
+        int newOrientation = t.compose[rot][orientation];
+
+        m_Hash ^= t.zobrist[cubie][slot][orientation];
+        m_Hash ^= t.zobrist[cubie][newSlot][newOrientation];
+
+        m_SlotOf[cubie] = static_cast<uint8_t>(newSlot);
+        m_Orientation[cubie] = static_cast<uint8_t>(newOrientation);
+    }
+    for (int i = 0; i < movedCount; ++i)
+    {
+        m_CubieAt[m_SlotOf[moved[i]]] = moved[i];
+    }
+}
+
+void CubeState::SetCubie(int cubie, int slot, int orientation)
+{
+    const RotationTables& t = Tables();
+    m_Hash ^= t.zobrist[cubie][m_SlotOf[cubie]][m_Orientation[cubie]];
+    m_SlotOf[cubie] = static_cast<uint8_t>(slot);
+    m_CubieAt[slot] = static_cast<uint8_t>(cubie);
+    m_Orientation[cubie] = static_cast<uint8_t>(orientation);
+    m_Hash ^= t.zobrist[cubie][slot][orientation];
+}
+
+bool CubeState::IsSolved() const
+{
+    // Solved up to a whole-cube rotation: every cubie shares the core's orientation and offset
+    int rot = m_Orientation[SlotIndex(glm::ivec3(0))];
+    for (int cubie = 0; cubie < CubieCount; ++cubie)
+    {
+        if (m_Orientation[cubie] != rot || m_SlotOf[cubie] != RotateSlot(rot, cubie))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t CubeState::ComputeHash() const
+{
+    const RotationTables& t = Tables();
+    uint64_t hash = 0;
+    for (int cubie = 0; cubie < CubieCount; ++cubie)
+    {
+        hash ^= t.zobrist[cubie][m_SlotOf[cubie]][m_Orientation[cubie]];
+    }
+    return hash;
+}
+
+uint64_t CubeState::CanonicalHash(int* transform) const
+{
+    const RotationTables& t = Tables();
+
+    // Undo whole-cube rotations first (the core only turns with the middle layers),
+    // then relabel colors under each of the 24 symmetries and keep the smallest hash
+    const int core = SlotIndex(glm::ivec3(0));
+    const int reorient = t.inverse[m_Orientation[core]];
+
+    uint64_t best = 0;
+    int bestTransform = 0;
+    for (int sym = 0; sym < OrientationCount; ++sym)
+    {
+        const int total = t.compose[sym][reorient];
+        const int symInverse = t.inverse[sym];
+        uint64_t hash = 0;
+        for (int cubie = 0; cubie < CubieCount; ++cubie)
+        {
+            int relabeled = t.rotateSlot[sym][cubie];
+            int slot = t.rotateSlot[total][m_SlotOf[cubie]];
+            int orientation = t.compose[total][t.compose[m_Orientation[cubie]][symInverse]];
+            hash ^= t.zobrist[relabeled][slot][orientation];
+        }
+        if (sym == 0 || hash < best)
+        {
+            best = hash;
+            bestTransform = total;
+        }
+    }
+
+    if (transform)
+    {
+        *transform = bestTransform;
+    }
+    return best;
+}
+
+bool CubeState::operator==(const CubeState& other) const
+{
+    for (int i = 0; i < CubieCount; ++i)
+    {
+        if (m_SlotOf[i] != other.m_SlotOf[i] || m_Orientation[i] != other.m_Orientation[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int CubeState::SlotIndex(const glm::ivec3& grid)
+{
+    return (grid.x + 1) * 9 + (grid.y + 1) * 3 + (grid.z + 1);
+}
+
+glm::ivec3 CubeState::SlotGrid(int slot)
+{
+    return glm::ivec3(slot / 9 - 1, (slot / 3) % 3 - 1, slot % 3 - 1);
+}
+
+int CubeState::OrientationIndex(const glm::mat3& orientation)
+{
+    return Tables().codeToIndex[MatrixCode(orientation)];
+}
+
+const glm::mat3& CubeState::OrientationMatrix(int index)
+{
+    return Tables().matrices[index];
+}
+
+int CubeState::ComposeOrientation(int outer, int inner)
+{
+    return Tables().compose[outer][inner];
+}
+
+int CubeState::InverseOrientation(int orientation)
+{
+    return Tables().inverse[orientation];
+}
+
+int CubeState::TurnOrientation(int axis, int turns)
+{
+    return Tables().turn[axis][((turns % 4) + 4) % 4];
+}
+
+int CubeState::RotateSlot(int orientation, int slot)
+{
+    return Tables().rotateSlot[orientation][slot];
+}
+
+CubeMove CubeState::TransformMove(const CubeMove& move, int orientation)
+{
+    // A turn about +axis becomes a turn about the rotated axis; a flipped axis mirrors layer and direction
+    glm::vec3 axisVec(0.0f);
+    axisVec[move.axis] = 1.0f;
+    int code = AxisCode(OrientationMatrix(orientation) * axisVec);
+    int sign = (code & 1) ? -1 : 1;
+
+    CubeMove result;
+    result.axis = code / 2;
+    result.layer = move.layer * sign;
+    result.turns = move.turns * sign;
+    return result;
+}
+
+uint64_t CubeState::ZobristKey(int cubie, int slot, int orientation)
+{
+    return Tables().zobrist[cubie][slot][orientation];
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+// A single layer turn, expressed as signed quarter turns about the positive axis
+struct CubeMove
+{
+    int axis = 0;   // 0 = X, 1 = Y, 2 = Z (same values as RubiksCube::Axis)
+    int layer = 0;  // -1, 0 or 1
+    int turns = 1;  // 1, 2 or -1
+};
+
+// Compact, GL-free state of the 3x3x3 puzzle for search and caching.
+// Cubie i starts in slot i (same order as RubiksCube::Initialize) with the identity orientation.
+// The 64-bit Zobrist hash is maintained incrementally, only the 9 moved cubies are rehashed per turn.
+class CubeState
+{
+    public:
+        static constexpr int CubieCount = 27;
+        static constexpr int OrientationCount = 24;
+    private:
+        uint8_t m_SlotOf[CubieCount];
+        uint8_t m_CubieAt[CubieCount];
+        uint8_t m_Orientation[CubieCount];
+        uint64_t m_Hash;
+    public:
+        CubeState();
+
+        void ApplyMove(const CubeMove& move);
+        void SetCubie(int cubie, int slot, int orientation);
+
+        bool IsSolved() const;
+        uint64_t ComputeHash() const;
+
+        // Hash normalized for whole-cube rotation and color relabeling (minimum over the 24 symmetries).
+        // 'transform' receives the rotation that maps moves of this state onto moves of the canonical one.
+        uint64_t CanonicalHash(int* transform = nullptr) const;
+
+        bool operator==(const CubeState& other) const;
+
+        inline uint64_t GetHash() const { return m_Hash; }
+        inline int GetSlot(int cubie) const { return m_SlotOf[cubie]; }
+        inline int GetCubieAt(int slot) const { return m_CubieAt[slot]; }
+        inline int GetOrientation(int cubie) const { return m_Orientation[cubie]; }
+
+        // Slot <-> grid coordinate in [-1, 1]^3
+        static int SlotIndex(const glm::ivec3& grid);
+        static glm::ivec3 SlotGrid(int slot);
+
+        // Index of an axis-aligned rotation matrix in the 24 element rotation group (-1 if not axis-aligned)
+        static int OrientationIndex(const glm::mat3& orientation);
+        static const glm::mat3& OrientationMatrix(int index);
+        static int ComposeOrientation(int outer, int inner);
+        static int InverseOrientation(int orientation);
+        static int TurnOrientation(int axis, int turns);
+        static int RotateSlot(int orientation, int slot);
+
+        static CubeMove TransformMove(const CubeMove& move, int orientation);
+
+        static uint64_t ZobristKey(int cubie, int slot, int orientation);
+};
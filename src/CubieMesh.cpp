@@ -0,0 +1,138 @@
+#include <CubieMesh.h>
+
+#include <RubiksCube.h>
+#include <VertexBufferLayout.h>
+
+#include <iterator>
+#include <vector>
+
+namespace
+{
+    // Positions, colors, texCoords, faceId (0..5 = +X -X +Y -Y +Z -Z)
+    const int VertexStride = 9;
+    const int TexCoordOffset = 6;
+    const int FaceIdOffset = 8;
+    const float Vertices[] = {
+        // Front face
+        -0.5f, -0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 0.0f,  4.0f,
+         0.5f, -0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 0.0f,  4.0f,
+         0.5f,  0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 1.0f,  4.0f,
+        -0.5f,  0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 1.0f,  4.0f,
+        // Back face
+         0.5f, -0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 0.0f,  5.0f,
+        -0.5f, -0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 0.0f,  5.0f,
+        -0.5f,  0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 1.0f,  5.0f,
+         0.5f,  0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 1.0f,  5.0f,
+        // Left face
+        -0.5f, -0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 0.0f,  1.0f,
+        -0.5f, -0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 0.0f,  1.0f,
+        -0.5f,  0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 1.0f,  1.0f,
+        -0.5f,  0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 1.0f,  1.0f,
+        // Right face
+         0.5f, -0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 0.0f,  0.0f,
+         0.5f, -0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 0.0f,  0.0f,
+         0.5f,  0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 1.0f,  0.0f,
+         0.5f,  0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 1.0f,  0.0f,
+        // Top face
+        -0.5f,  0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 0.0f,  2.0f,
+         0.5f,  0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 0.0f,  2.0f,
+         0.5f,  0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 1.0f,  2.0f,
+        -0.5f,  0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 1.0f,  2.0f,
+        // Bottom face
+        -0.5f, -0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 0.0f,  3.0f,
+         0.5f, -0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 0.0f,  3.0f,
+         0.5f, -0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 1.0f,  3.0f,
+        -0.5f, -0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 1.0f,  3.0f
+    };
+
+    const unsigned int Indices[] = {
+        0, 1, 2, 2, 3, 0,       // Front
+        4, 5, 6, 6, 7, 4,       // Back
+        8, 9, 10, 10, 11, 8,    // Left
+        12, 13, 14, 14, 15, 12, // Right
+        16, 17, 18, 18, 19, 16, // Top
+        20, 21, 22, 22, 23, 20  // Bottom
+    };
+}
+
+CubieMesh::CubieMesh()
+    : m_VertexBuffer(Vertices, sizeof(Vertices))
+{
+    // The whole cube first, then the quads of every face subset; each quad is 6 consecutive indices
+    std::vector<unsigned int> indices(std::begin(Indices), std::end(Indices));
+    const int quadCount = static_cast<int>(indices.size()) / 6;
+    m_CubeRange.firstIndex = 0;
+    m_CubeRange.indexCount = static_cast<uint32_t>(indices.size());
+
+    for (uint32_t mask = 0; mask < m_FaceRanges.size(); ++mask)
+    {
+        m_FaceRanges[mask].firstIndex = static_cast<uint32_t>(indices.size());
+        for (int quad = 0; quad < quadCount; ++quad)
+        {
+            int face = static_cast<int>(Vertices[Indices[quad * 6] * VertexStride + FaceIdOffset]);
+            if (mask & (1u << face))
+            {
+                indices.insert(indices.end(), Indices + quad * 6, Indices + quad * 6 + 6);
+            }
+        }
+        m_FaceRanges[mask].indexCount = static_cast<uint32_t>(indices.size()) - m_FaceRanges[mask].firstIndex;
+    }
+    m_IndexBuffer = std::make_unique<IndexBuffer>(indices.data(), static_cast<unsigned int>(indices.size() * sizeof(unsigned int)));
+
+    VertexBufferLayout layout;
+    layout.Push<float>(3);  // positions
+    layout.Push<float>(3);  // colors
+    layout.Push<float>(2);  // texCoords
+    layout.Push<float>(1);  // faceId
+    m_VertexArray.AddBuffer(m_VertexBuffer, layout);
+
+    // The element buffer binding is vertex array state, record it in the mesh's VAO
+    m_IndexBuffer->Bind();
+    m_VertexArray.Unbind();
+    m_VertexBuffer.Unbind();
+}
+
+const MeshRange& CubieMesh::GetStickerRange(uint32_t facePalette) const
+{
+    uint32_t mask = 0;
+    for (int face = 0; face < FaceCount; ++face)
+    {
+        if (RubiksCube::GetFacePaletteIndex(facePalette, face) != RubiksCube::ColorNone)
+        {
+            mask |= 1u << face;
+        }
+    }
+    return m_FaceRanges[mask];
+}
+
+glm::vec2 CubieMesh::GetFaceTexCoord(int face, const glm::vec3& position)
+{
+    // The face's corners with texCoord (0, 0), (1, 0) and (0, 1) span its texture axes
+    glm::vec3 corners[3] = { glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f) };
+    const int vertexCount = static_cast<int>(std::size(Vertices)) / VertexStride;
+    for (int v = 0; v < vertexCount; ++v)
+    {
+        const float* vertex = Vertices + v * VertexStride;
+        if (static_cast<int>(vertex[FaceIdOffset]) != face)
+        {
+            continue;
+        }
+        glm::vec3 corner(vertex[0], vertex[1], vertex[2]);
+        float u = vertex[TexCoordOffset];
+        float t = vertex[TexCoordOffset + 1];
+        if (u == 0.0f && t == 0.0f)
+        {
+            corners[0] = corner;
+        }
+        else if (u == 1.0f && t == 0.0f)
+        {
+            corners[1] = corner;
+        }
+        else if (u == 0.0f && t == 1.0f)
+        {
+            corners[2] = corner;
+        }
+    }
+    glm::vec3 offset = position - corners[0];
+    return glm::vec2(glm::dot(offset, corners[1] - corners[0]), glm::dot(offset, corners[2] - corners[0]));
+}
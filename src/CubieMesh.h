@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <IndexBuffer.h>
+#include <Renderer.h>
+#include <VertexArray.h>
+#include <VertexBuffer.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+// Unit cube with per-face texture coordinates and face ids, shared by every cubie of every puzzle.
+// Per-cubie transforms and colors come from instance data, so one mesh serves any number of cubes.
+// Besides the whole cube, the index buffer holds one range per subset of faces: a cubie that sits in
+// place only needs the faces carrying stickers, the rest of the puzzle is covered by black bodies.
+class CubieMesh
+{
+    public:
+        static const int FaceCount = 6;
+    private:
+        VertexArray m_VertexArray;
+        VertexBuffer m_VertexBuffer;
+        std::unique_ptr<IndexBuffer> m_IndexBuffer;
+        MeshRange m_CubeRange;
+        std::array<MeshRange, 1 << FaceCount> m_FaceRanges;  // Indexed by face bitmask
+    public:
+        CubieMesh();
+
+        CubieMesh(const CubieMesh&) = delete;
+        CubieMesh& operator=(const CubieMesh&) = delete;
+
+        inline const VertexArray& GetVertexArray() const { return m_VertexArray; }
+        inline const IndexBuffer& GetIndexBuffer() const { return *m_IndexBuffer; }
+
+        // All six faces, for cubies moved out of place and for the bodies
+        inline const MeshRange& GetCubeRange() const { return m_CubeRange; }
+        // Only the faces with a sticker color; empty (indexCount 0) for cubies without any
+        const MeshRange& GetStickerRange(uint32_t facePalette) const;
+
+        // Texture coordinates of a point on the given face of the unit cube, for images baked to match the mesh
+        static glm::vec2 GetFaceTexCoord(int face, const glm::vec3& position);
+};
@@ -0,0 +1,236 @@
+#include <FileWatcher.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // How often the watcher thread checks for shutdown (and, when polling, for a new mtime)
+    const std::chrono::milliseconds PollInterval(100);
+
+    // Editors often write a file in several steps; wait for them to settle before reporting
+    const std::chrono::milliseconds SettleTime(50);
+
+    // State shared by every FileWatcher of the process
+    struct WatchHub
+    {
+        std::mutex lifecycle;  // Serializes starting and stopping the thread
+        std::mutex mutex;      // Guards everything below, also taken by the thread
+        std::vector<FileWatcher*> watchers;
+        std::map<int, std::string> directories;  // inotify watch descriptor -> directory
+        int fd = -1;
+        std::atomic<bool> quit{ false };
+        std::thread thread;
+    };
+
+    WatchHub& Hub()
+    {
+        static WatchHub hub;
+        return hub;
+    }
+}
+
+FileWatcher::FileWatcher(const std::string& filepath)
+    : m_Filepath(filepath), m_Changed(false), m_Polled(true)
+{
+    std::filesystem::path path = std::filesystem::path(filepath).lexically_normal();
+    m_Directory = path.has_parent_path() ? path.parent_path().string() : ".";
+    m_Filename = path.filename().string();
+
+    std::error_code error;
+    m_LastWrite = std::filesystem::last_write_time(m_Filepath, error);
+    Subscribe(this);
+}
+
+FileWatcher::~FileWatcher()
+{
+    Unsubscribe(this);
+}
+
+void FileWatcher::Subscribe(FileWatcher* watcher)
+{
+    WatchHub& hub = Hub();
+    std::lock_guard<std::mutex> lifecycle(hub.lifecycle);
+    {
+        std::lock_guard<std::mutex> lock(hub.mutex);
+#ifdef __linux__
+        if (hub.fd < 0)
+        {
+            hub.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        }
+        if (hub.fd >= 0)
+        {
+            // Adding a directory twice returns its existing descriptor
+            int wd = inotify_add_watch(hub.fd, watcher->m_Directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+            if (wd >= 0)
+            {
+                hub.directories[wd] = watcher->m_Directory;
+                watcher->m_Polled = false;
+            }
+        }
+        if (watcher->m_Polled)
+        {
+            std::cout << "inotify unavailable for " << watcher->m_Filepath << ", polling instead" << std::endl;
+        }
+#endif
+        hub.watchers.push_back(watcher);
+    }
+
+    if (!hub.thread.joinable())
+    {
+        hub.quit.store(false);
+        hub.thread = std::thread(&FileWatcher::Run);
+    }
+}
+
+void FileWatcher::Unsubscribe(FileWatcher* watcher)
+{
+    WatchHub& hub = Hub();
+    std::lock_guard<std::mutex> lifecycle(hub.lifecycle);
+    bool last = false;
+    {
+        std::lock_guard<std::mutex> lock(hub.mutex);
+        hub.watchers.erase(std::remove(hub.watchers.begin(), hub.watchers.end(), watcher), hub.watchers.end());
+#ifdef __linux__
+        // Drop the directory's watch once nobody is interested in it
+        bool shared = std::any_of(hub.watchers.begin(), hub.watchers.end(),
+            [watcher](const FileWatcher* other) { return !other->m_Polled && other->m_Directory == watcher->m_Directory; });
+        if (!watcher->m_Polled && !shared)
+        {
+            for (auto it = hub.directories.begin(); it != hub.directories.end(); ++it)
+            {
+                if (it->second == watcher->m_Directory)
+                {
+                    inotify_rm_watch(hub.fd, it->first);
+                    hub.directories.erase(it);
+                    break;
+                }
+            }
+        }
+#endif
+        last = hub.watchers.empty();
+    }
+
+    // The thread only runs while something is watched, so nothing outlives the last watcher
+    if (last && hub.thread.joinable())
+    {
+        hub.quit.store(true);
+        hub.thread.join();
+#ifdef __linux__
+        std::lock_guard<std::mutex> lock(hub.mutex);
+        if (hub.fd >= 0)
+        {
+            close(hub.fd);
+            hub.fd = -1;
+            hub.directories.clear();
+        }
+#endif
+    }
+}
+
+void FileWatcher::Run()
+{
+    WatchHub& hub = Hub();
+    while (!hub.quit.load())
+    {
+        // Files touched since the last pass, as (directory, filename)
+        std::set<std::pair<std::string, std::string>> touched;
+#ifdef __linux__
+        int fd = -1;
+        {
+            std::lock_guard<std::mutex> lock(hub.mutex);
+            fd = hub.fd;
+        }
+        if (fd >= 0)
+        {
+            pollfd descriptor = { fd, POLLIN, 0 };
+            if (poll(&descriptor, 1, static_cast<int>(PollInterval.count())) > 0)
+            {
+                alignas(inotify_event) char buffer[4096];
+                auto drain = [&]()
+                {
+                    ssize_t length = 0;
+                    while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+                    {
+                        std::lock_guard<std::mutex> lock(hub.mutex);
+                        for (char* it = buffer; it < buffer + length; it += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(it)->len)
+                        {
+                            const inotify_event* event = reinterpret_cast<const inotify_event*>(it);
+                            auto directory = hub.directories.find(event->wd);
+                            if (event->len > 0 && directory != hub.directories.end())
+                            {
+                                touched.emplace(directory->second, event->name);
+                            }
+                        }
+                    }
+                };
+                drain();
+
+                // Swallow the rest of the save before reporting it once
+                if (!touched.empty())
+                {
+                    std::this_thread::sleep_for(SettleTime);
+                    drain();
+                }
+            }
+        }
+        else
+        {
+            std::this_thread::sleep_for(PollInterval);
+        }
+#else
+        std::this_thread::sleep_for(PollInterval);
+#endif
+
+        std::vector<FileWatcher*> polledChanges;
+        {
+            std::lock_guard<std::mutex> lock(hub.mutex);
+            for (FileWatcher* watcher : hub.watchers)
+            {
+                if (!watcher->m_Polled)
+                {
+                    if (touched.count({ watcher->m_Directory, watcher->m_Filename }) > 0)
+                    {
+                        watcher->m_Changed.store(true);
+                    }
+                    continue;
+                }
+
+                std::error_code error;
+                auto writeTime = std::filesystem::last_write_time(watcher->m_Filepath, error);
+                if (!error && writeTime != watcher->m_LastWrite)
+                {
+                    watcher->m_LastWrite = writeTime;
+                    polledChanges.push_back(watcher);
+                }
+            }
+        }
+
+        // Give polled saves the same time to settle; a watcher may have gone away meanwhile
+        if (!polledChanges.empty())
+        {
+            std::this_thread::sleep_for(SettleTime);
+            std::lock_guard<std::mutex> lock(hub.mutex);
+            for (FileWatcher* watcher : polledChanges)
+            {
+                if (std::find(hub.watchers.begin(), hub.watchers.end(), watcher) != hub.watchers.end())
+                {
+                    watcher->m_Changed.store(true);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+
+// Watches a single file for modifications.
+// Every FileWatcher in the process shares one background thread. On Linux that thread also owns a
+// single inotify instance, with one watch per parent directory however many files in it are watched;
+// the directory is watched because most editors save by writing a temporary file and renaming it over
+// the original. Files inotify can't watch, and every file on other platforms, are polled for their
+// modification time instead.
+class FileWatcher
+{
+    private:
+        std::string m_Filepath;
+        std::string m_Directory;
+        std::string m_Filename;
+        std::atomic<bool> m_Changed;
+
+        // Polling fallback, only touched by the shared thread
+        bool m_Polled;
+        std::filesystem::file_time_type m_LastWrite;
+    public:
+        FileWatcher(const std::string& filepath);
+        ~FileWatcher();
+
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+        // True once for any number of changes since the previous call
+        inline bool ConsumeChange() { return m_Changed.exchange(false); }
+    private:
+        static void Subscribe(FileWatcher* watcher);
+        static void Unsubscribe(FileWatcher* watcher);
+        static void Run();
+};
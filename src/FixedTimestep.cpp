@@ -0,0 +1,31 @@
+#include <FixedTimestep.h>
+
+FixedTimestep::FixedTimestep(double step, int maxStepsPerFrame)
+    : m_Step(step), m_Accumulator(0.0), m_MaxStepsPerFrame(maxStepsPerFrame), m_TickCount(0)
+{
+}
+
+int FixedTimestep::Advance(double frameTime)
+{
+    if (frameTime < 0.0)
+    {
+        frameTime = 0.0;
+    }
+
+    m_Accumulator += frameTime;
+    int steps = 0;
+    while (m_Accumulator >= m_Step && steps < m_MaxStepsPerFrame)
+    {
+        m_Accumulator -= m_Step;
+        ++steps;
+    }
+
+    if (m_Accumulator >= m_Step)
+    {
+        // Drop the backlog, keep only the sub-step remainder for interpolation
+        m_Accumulator -= m_Step * static_cast<int>(m_Accumulator / m_Step);
+    }
+
+    m_TickCount += steps;
+    return steps;
+}
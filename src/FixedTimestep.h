@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+// Accumulator for a fixed simulation step decoupled from the render rate.
+// Each frame, Advance() reports how many whole steps to simulate; the leftover
+// fraction is exposed as GetAlpha() to interpolate rendering between steps.
+class FixedTimestep
+{
+    private:
+        double m_Step;
+        double m_Accumulator;
+        int m_MaxStepsPerFrame;
+        uint64_t m_TickCount;
+    public:
+        FixedTimestep(double step = 1.0 / 120.0, int maxStepsPerFrame = 8);
+
+        // Steps to simulate for 'frameTime' seconds of wall time, capped at maxStepsPerFrame
+        // so a long hitch drops time instead of spiralling into ever longer frames
+        int Advance(double frameTime);
+
+        inline float GetAlpha() const { return static_cast<float>(m_Accumulator / m_Step); }
+        inline float GetStepSeconds() const { return static_cast<float>(m_Step); }
+        inline uint64_t GetTickCount() const { return m_TickCount; }
+};
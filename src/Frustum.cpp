@@ -0,0 +1,40 @@
+#include <Frustum.h>
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+    // Gribb/Hartmann: a clip-space point is inside when -w <= x, y, z <= w, i.e. row3 +- row[0..2] >= 0
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        m_Planes[2 * axis] = rows[3] + rows[axis];
+        m_Planes[2 * axis + 1] = rows[3] - rows[axis];
+    }
+
+    for (glm::vec4& plane : m_Planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+Frustum::Result Frustum::TestSphere(const glm::vec3& center, float radius) const
+{
+    Result result = Inside;
+    for (const glm::vec4& plane : m_Planes)
+    {
+        float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+        if (distance < -radius)
+        {
+            return Outside;
+        }
+        if (distance < radius)
+        {
+            result = Intersecting;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+// The six clip planes of a view-projection matrix, for culling bounding volumes on the CPU.
+// Planes point inwards and are normalized, so plane distances are in world units.
+class Frustum
+{
+    public:
+        enum Result
+        {
+            Outside = 0,
+            Intersecting = 1,
+            Inside = 2
+        };
+    private:
+        std::array<glm::vec4, 6> m_Planes;  // Left, right, bottom, top, near, far
+    public:
+        explicit Frustum(const glm::mat4& viewProjection);
+
+        // Inside means no child volume needs testing
+        Result TestSphere(const glm::vec3& center, float radius) const;
+        inline bool IntersectsSphere(const glm::vec3& center, float radius) const { return TestSphere(center, radius) != Outside; }
+};
@@ -0,0 +1,78 @@
+#include <GLExtensions.h>
+
+#include <Debugger.h>
+
+bool GLExtensions::ProgramBinary = false;
+PFNGLGETPROGRAMBINARYEXTPROC GLExtensions::GetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYEXTPROC GLExtensions::LoadProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIEXTPROC GLExtensions::ProgramParameteri = nullptr;
+bool GLExtensions::BufferStorage = false;
+PFNGLBUFFERSTORAGEEXTPROC GLExtensions::AllocateBufferStorage = nullptr;
+bool GLExtensions::MultiDrawIndirect = false;
+PFNGLMULTIDRAWELEMENTSINDIRECTEXTPROC GLExtensions::MultiDrawElementsIndirect = nullptr;
+bool GLExtensions::TextureCompressionS3TC = false;
+bool GLExtensions::ParallelShaderCompile = false;
+
+void GLExtensions::Load(GLADloadproc loader)
+{
+    if (HasVersion(4, 1) || HasExtension("GL_ARB_get_program_binary"))
+    {
+        GetProgramBinary = (PFNGLGETPROGRAMBINARYEXTPROC)loader("glGetProgramBinary");
+        LoadProgramBinary = (PFNGLPROGRAMBINARYEXTPROC)loader("glProgramBinary");
+        ProgramParameteri = (PFNGLPROGRAMPARAMETERIEXTPROC)loader("glProgramParameteri");
+
+        // A driver may expose the entry points but support no binary format at all
+        int formats = 0;
+        GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+        ProgramBinary = GetProgramBinary && LoadProgramBinary && ProgramParameteri && formats > 0;
+    }
+
+    if (HasVersion(4, 4) || HasExtension("GL_ARB_buffer_storage"))
+    {
+        AllocateBufferStorage = (PFNGLBUFFERSTORAGEEXTPROC)loader("glBufferStorage");
+        BufferStorage = AllocateBufferStorage != nullptr;
+    }
+
+    // Without ARB_base_instance the baseInstance field is reserved and instance ranges can't be addressed
+    if (HasVersion(4, 3) || (HasExtension("GL_ARB_multi_draw_indirect") && HasExtension("GL_ARB_base_instance")))
+    {
+        MultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTEXTPROC)loader("glMultiDrawElementsIndirect");
+        MultiDrawIndirect = MultiDrawElementsIndirect != nullptr;
+    }
+
+    TextureCompressionS3TC = HasExtension("GL_EXT_texture_compression_s3tc");
+
+    ParallelShaderCompile = HasExtension("GL_KHR_parallel_shader_compile") || HasExtension("GL_ARB_parallel_shader_compile");
+}
+
+bool GLExtensions::HasVersion(int major, int minor)
+{
+    return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+bool GLExtensions::HasExtension(const std::string& name)
+{
+    int count = 0;
+    GLCall(glGetIntegerv(GL_NUM_EXTENSIONS, &count));
+    for (int i = 0; i < count; ++i)
+    {
+        GLCall(const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)));
+        if (extension && name == extension)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string GLExtensions::GetDriverString()
+{
+    std::string driver;
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+    {
+        GLCall(const char* value = reinterpret_cast<const char*>(glGetString(name)));
+        driver += value ? value : "";
+        driver += '\n';
+    }
+    return driver;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <string>
+
+// glad is generated for the GL 3.3 core profile only, so anything newer is loaded here at runtime.
+// Every feature has a flag; callers must check it and keep a GL 3.3 fallback.
+
+// ARB_get_program_binary (core in 4.1)
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH           0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+
+// ARB_buffer_storage (core in 4.4)
+#define GL_MAP_PERSISTENT_BIT              0x0040
+#define GL_MAP_COHERENT_BIT                0x0080
+#define GL_DYNAMIC_STORAGE_BIT             0x0100
+#define GL_CLIENT_STORAGE_BIT              0x0200
+
+// ARB_draw_indirect (core in 4.0)
+#define GL_DRAW_INDIRECT_BUFFER            0x8F3F
+
+// EXT_texture_compression_s3tc (BC1; never core, BC4 is core since 3.0 as GL_COMPRESSED_RED_RGTC1)
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT    0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT   0x83F1
+
+// KHR/ARB_parallel_shader_compile
+#define GL_COMPLETION_STATUS               0x91B1
+
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYEXTPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYEXTPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIEXTPROC)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEEXTPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTEXTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+
+class GLExtensions
+{
+    public:
+        static bool ProgramBinary;
+        static PFNGLGETPROGRAMBINARYEXTPROC GetProgramBinary;
+        static PFNGLPROGRAMBINARYEXTPROC LoadProgramBinary;
+        static PFNGLPROGRAMPARAMETERIEXTPROC ProgramParameteri;
+
+        // Immutable storage that can stay mapped while the GPU reads it
+        static bool BufferStorage;
+        static PFNGLBUFFERSTORAGEEXTPROC AllocateBufferStorage;
+
+        // Many indexed draws from a buffer of commands in one call, each with its own base instance
+        static bool MultiDrawIndirect;
+        static PFNGLMULTIDRAWELEMENTSINDIRECTEXTPROC MultiDrawElementsIndirect;
+
+        // BC1 compressed textures can be uploaded
+        static bool TextureCompressionS3TC;
+
+        // GL_COMPLETION_STATUS can be queried without blocking on the compiler
+        static bool ParallelShaderCompile;
+    public:
+        // Call once after gladLoadGL() with the context current, e.g. Load((GLADloadproc)glfwGetProcAddress)
+        static void Load(GLADloadproc loader);
+
+        static bool HasVersion(int major, int minor);
+        static bool HasExtension(const std::string& name);
+
+        // Vendor, renderer and version strings; binaries and other driver-specific data are keyed by it
+        static std::string GetDriverString();
+};
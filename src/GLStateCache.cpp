@@ -0,0 +1,182 @@
+#include <GLStateCache.h>
+
+#include <Debugger.h>
+
+unsigned int GLStateCache::s_Program = GLStateCache::Unknown;
+unsigned int GLStateCache::s_VertexArray = GLStateCache::Unknown;
+unsigned int GLStateCache::s_ActiveTextureUnit = GLStateCache::Unknown;
+std::unordered_map<unsigned int, unsigned int> GLStateCache::s_Buffers;
+std::unordered_map<unsigned int, unsigned int> GLStateCache::s_ElementBuffers;
+std::unordered_map<uint64_t, unsigned int> GLStateCache::s_Textures;
+std::unordered_map<unsigned int, bool> GLStateCache::s_Capabilities;
+std::atomic<uint64_t> GLStateCache::s_Issued(0);
+std::atomic<uint64_t> GLStateCache::s_Skipped(0);
+
+bool GLStateCache::Track(unsigned int& cached, unsigned int value)
+{
+    if (cached == value)
+    {
+        s_Skipped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    cached = value;
+    s_Issued.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void GLStateCache::UseProgram(unsigned int program)
+{
+    if (Track(s_Program, program))
+    {
+        GLCall(glUseProgram(program));
+    }
+}
+
+void GLStateCache::BindVertexArray(unsigned int vertexArray)
+{
+    if (Track(s_VertexArray, vertexArray))
+    {
+        GLCall(glBindVertexArray(vertexArray));
+    }
+}
+
+void GLStateCache::BindBuffer(unsigned int target, unsigned int buffer)
+{
+    // The element buffer binding is stored in the bound VAO, so it is tracked per VAO
+    unsigned int* cached = nullptr;
+    if (target == GL_ELEMENT_ARRAY_BUFFER)
+    {
+        if (s_VertexArray == Unknown)
+        {
+            GLCall(glBindBuffer(target, buffer));
+            s_Issued.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        cached = &s_ElementBuffers.emplace(s_VertexArray, Unknown).first->second;
+    }
+    else
+    {
+        cached = &s_Buffers.emplace(target, Unknown).first->second;
+    }
+
+    if (Track(*cached, buffer))
+    {
+        GLCall(glBindBuffer(target, buffer));
+    }
+}
+
+void GLStateCache::BindBufferBase(unsigned int target, unsigned int index, unsigned int buffer)
+{
+    // Indexed bindings are not tracked, but the call also binds the generic target
+    GLCall(glBindBufferBase(target, index, buffer));
+    s_Buffers[target] = buffer;
+    s_Issued.fetch_add(1, std::memory_order_relaxed);
+}
+
+void GLStateCache::BindTexture(unsigned int unit, unsigned int target, unsigned int texture)
+{
+    unsigned int& cached = s_Textures.emplace((static_cast<uint64_t>(unit) << 32) | target, Unknown).first->second;
+    if (cached == texture)
+    {
+        s_Skipped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (Track(s_ActiveTextureUnit, unit))
+    {
+        GLCall(glActiveTexture(GL_TEXTURE0 + unit));
+    }
+    cached = texture;
+    GLCall(glBindTexture(target, texture));
+    s_Issued.fetch_add(1, std::memory_order_relaxed);
+}
+
+void GLStateCache::SetEnabled(unsigned int capability, bool enabled)
+{
+    auto it = s_Capabilities.find(capability);
+    if (it != s_Capabilities.end() && it->second == enabled)
+    {
+        s_Skipped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    s_Capabilities[capability] = enabled;
+    s_Issued.fetch_add(1, std::memory_order_relaxed);
+    if (enabled)
+    {
+        GLCall(glEnable(capability));
+    }
+    else
+    {
+        GLCall(glDisable(capability));
+    }
+}
+
+void GLStateCache::ForgetProgram(unsigned int program)
+{
+    if (s_Program == program)
+    {
+        s_Program = Unknown;
+    }
+}
+
+void GLStateCache::ForgetVertexArray(unsigned int vertexArray)
+{
+    if (s_VertexArray == vertexArray)
+    {
+        s_VertexArray = Unknown;
+    }
+    s_ElementBuffers.erase(vertexArray);
+}
+
+void GLStateCache::ForgetBuffer(unsigned int buffer)
+{
+    for (auto& binding : s_Buffers)
+    {
+        if (binding.second == buffer)
+        {
+            binding.second = Unknown;
+        }
+    }
+    for (auto& binding : s_ElementBuffers)
+    {
+        if (binding.second == buffer)
+        {
+            binding.second = Unknown;
+        }
+    }
+}
+
+void GLStateCache::ForgetTexture(unsigned int texture)
+{
+    for (auto& binding : s_Textures)
+    {
+        if (binding.second == texture)
+        {
+            binding.second = Unknown;
+        }
+    }
+}
+
+void GLStateCache::Invalidate()
+{
+    s_Program = Unknown;
+    s_VertexArray = Unknown;
+    s_ActiveTextureUnit = Unknown;
+    s_Buffers.clear();
+    s_ElementBuffers.clear();
+    s_Textures.clear();
+    s_Capabilities.clear();
+}
+
+GLStateCache::Counters GLStateCache::GetCounters()
+{
+    Counters counters;
+    counters.issued = s_Issued.load(std::memory_order_relaxed);
+    counters.skipped = s_Skipped.load(std::memory_order_relaxed);
+    return counters;
+}
+
+void GLStateCache::ResetCounters()
+{
+    s_Issued.store(0, std::memory_order_relaxed);
+    s_Skipped.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+
+// Shadow copy of the GL binding state, so redundant binds and enables never reach the driver.
+// It is only correct while every bind goes through it: code that changes these bindings directly
+// must call Invalidate(). Bindings belong to the context, so use it from the thread that owns it.
+class GLStateCache
+{
+    public:
+        struct Counters
+        {
+            uint64_t issued = 0;
+            uint64_t skipped = 0;
+        };
+    private:
+        static constexpr unsigned int Unknown = ~0u;
+
+        static unsigned int s_Program;
+        static unsigned int s_VertexArray;
+        static unsigned int s_ActiveTextureUnit;
+        static std::unordered_map<unsigned int, unsigned int> s_Buffers;         // Target -> buffer, except element buffers
+        static std::unordered_map<unsigned int, unsigned int> s_ElementBuffers;  // VAO -> element buffer (VAO state)
+        static std::unordered_map<uint64_t, unsigned int> s_Textures;            // (unit, target) -> texture
+        static std::unordered_map<unsigned int, bool> s_Capabilities;
+
+        // Written by the render thread, read by the profiler on the main thread
+        static std::atomic<uint64_t> s_Issued;
+        static std::atomic<uint64_t> s_Skipped;
+    public:
+        static void UseProgram(unsigned int program);
+        static void BindVertexArray(unsigned int vertexArray);
+        static void BindBuffer(unsigned int target, unsigned int buffer);
+        static void BindBufferBase(unsigned int target, unsigned int index, unsigned int buffer);
+        static void BindTexture(unsigned int unit, unsigned int target, unsigned int texture);
+        static void SetEnabled(unsigned int capability, bool enabled);
+
+        // GL unbinds deleted objects and may reuse their names, so forget them before deleting
+        static void ForgetProgram(unsigned int program);
+        static void ForgetVertexArray(unsigned int vertexArray);
+        static void ForgetBuffer(unsigned int buffer);
+        static void ForgetTexture(unsigned int texture);
+
+        static void Invalidate();
+
+        static Counters GetCounters();
+        static void ResetCounters();
+    private:
+        static bool Track(unsigned int& cached, unsigned int value);
+};
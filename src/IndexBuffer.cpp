@@ -1,4 +1,5 @@
 #include <IndexBuffer.h>
+#include <GLStateCache.h>
 
 IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int size)
     : m_Count(size / sizeof(unsigned int))
@@ -6,21 +7,22 @@ IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int size)
     ASSERT(sizeof(unsigned int) == sizeof(GLuint));
 
     GLCall(glGenBuffers(1, &m_RendererID));
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+    GLStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID);
     GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
 }
 
 IndexBuffer::~IndexBuffer()
 {
+    GLStateCache::ForgetBuffer(m_RendererID);
     GLCall(glDeleteBuffers(1, &m_RendererID));
 }
 
 void IndexBuffer::Bind() const
 {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+    GLStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID);
 }
 
 void IndexBuffer::Unbind() const
 {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    GLStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
\ No newline at end of file
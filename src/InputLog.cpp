@@ -0,0 +1,268 @@
+#include <InputLog.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace
+{
+    const uint32_t InputLogMagic = 0x474C4E49; // "INLG"
+    const uint32_t InputLogVersion = 1;
+
+    enum SettingsFlags : uint8_t
+    {
+        DepthPrepassFlag = 1,
+        BufferStorageFlag = 2,
+        MultiDrawFlag = 4,
+        ProceduralStickersFlag = 8
+    };
+
+    void WriteVarint(std::vector<uint8_t>& out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    void WriteSigned(std::vector<uint8_t>& out, int value)
+    {
+        // Zigzag so small negative codes (GLFW_KEY_UNKNOWN) stay one byte
+        uint32_t v = static_cast<uint32_t>(value);
+        WriteVarint(out, (v << 1) ^ static_cast<uint32_t>(value >> 31));
+    }
+
+    void WriteFloat(std::vector<uint8_t>& out, float value)
+    {
+        uint8_t bytes[sizeof(float)];
+        std::memcpy(bytes, &value, sizeof(float));
+        out.insert(out.end(), bytes, bytes + sizeof(float));
+    }
+
+    void WriteString(std::vector<uint8_t>& out, const std::string& value)
+    {
+        WriteVarint(out, value.size());
+        out.insert(out.end(), value.begin(), value.end());
+    }
+
+    struct Reader
+    {
+        const std::vector<uint8_t>& data;
+        size_t pos;
+        bool ok;
+
+        uint64_t Varint()
+        {
+            uint64_t value = 0;
+            int shift = 0;
+            while (pos < data.size() && shift < 64)
+            {
+                uint8_t byte = data[pos++];
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80))
+                {
+                    return value;
+                }
+                shift += 7;
+            }
+            ok = false;
+            return 0;
+        }
+
+        int Signed()
+        {
+            uint32_t v = static_cast<uint32_t>(Varint());
+            return static_cast<int>((v >> 1) ^ (~(v & 1) + 1));
+        }
+
+        uint8_t Byte()
+        {
+            if (pos >= data.size())
+            {
+                ok = false;
+                return 0;
+            }
+            return data[pos++];
+        }
+
+        float Float()
+        {
+            float value = 0.0f;
+            if (pos + sizeof(float) > data.size())
+            {
+                ok = false;
+                return value;
+            }
+            std::memcpy(&value, &data[pos], sizeof(float));
+            pos += sizeof(float);
+            return value;
+        }
+
+        std::string String()
+        {
+            uint64_t size = Varint();
+            if (!ok || size > data.size() - pos)
+            {
+                ok = false;
+                return std::string();
+            }
+            std::string value(data.begin() + pos, data.begin() + pos + size);
+            pos += size;
+            return value;
+        }
+    };
+}
+
+InputLog::InputLog()
+    : m_Cursor(0)
+{
+}
+
+void InputLog::Record(const InputEvent& event)
+{
+    m_Events.push_back(event);
+}
+
+bool InputLog::Save(const std::string& filepath) const
+{
+    std::vector<uint8_t> data;
+    data.reserve(16 + m_Events.size() * 8);
+    WriteVarint(data, InputLogMagic);
+    WriteVarint(data, InputLogVersion);
+    WriteFloat(data, m_Settings.animationSpeed);
+    data.push_back(static_cast<uint8_t>(m_Settings.animationMode));
+    uint8_t flags = (m_Settings.depthPrepass ? DepthPrepassFlag : 0) | (m_Settings.bufferStorage ? BufferStorageFlag : 0)
+        | (m_Settings.multiDraw ? MultiDrawFlag : 0) | (m_Settings.proceduralStickers ? ProceduralStickersFlag : 0);
+    data.push_back(flags);
+    WriteSigned(data, m_Settings.wallSize);
+    WriteFloat(data, m_Settings.lodPixels);
+    WriteVarint(data, m_Settings.stickerFiles.size());
+    for (const std::string& file : m_Settings.stickerFiles)
+    {
+        WriteString(data, file);
+    }
+    WriteVarint(data, m_Events.size());
+
+    uint64_t lastTick = 0;
+    for (const InputEvent& event : m_Events)
+    {
+        WriteVarint(data, event.tick - lastTick);
+        lastTick = event.tick;
+        data.push_back(event.type);
+        switch (event.type)
+        {
+            case InputEvent::Key:
+                WriteSigned(data, event.code);
+                data.push_back(static_cast<uint8_t>(event.action));
+                data.push_back(static_cast<uint8_t>(event.mods));
+                break;
+            case InputEvent::MouseButton:
+                data.push_back(static_cast<uint8_t>(event.code));
+                data.push_back(static_cast<uint8_t>(event.action));
+                data.push_back(static_cast<uint8_t>(event.mods));
+                WriteFloat(data, event.x);
+                WriteFloat(data, event.y);
+                break;
+            default:
+                WriteFloat(data, event.x);
+                WriteFloat(data, event.y);
+                break;
+        }
+    }
+
+    std::ofstream stream(filepath, std::ios::binary | std::ios::trunc);
+    if (!stream)
+    {
+        std::cout << "Failed to open input log for writing: " << filepath << std::endl;
+        return false;
+    }
+    stream.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return static_cast<bool>(stream);
+}
+
+bool InputLog::Load(const std::string& filepath)
+{
+    std::ifstream stream(filepath, std::ios::binary);
+    if (!stream)
+    {
+        std::cout << "Failed to open input log: " << filepath << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    Reader reader = { data, 0, true };
+    if (reader.Varint() != InputLogMagic || reader.Varint() != InputLogVersion)
+    {
+        std::cout << "Not an input log (or unsupported version): " << filepath << std::endl;
+        return false;
+    }
+    m_Settings.animationSpeed = reader.Float();
+    m_Settings.animationMode = reader.Byte();
+    uint8_t flags = reader.Byte();
+    m_Settings.depthPrepass = (flags & DepthPrepassFlag) != 0;
+    m_Settings.bufferStorage = (flags & BufferStorageFlag) != 0;
+    m_Settings.multiDraw = (flags & MultiDrawFlag) != 0;
+    m_Settings.proceduralStickers = (flags & ProceduralStickersFlag) != 0;
+    m_Settings.wallSize = reader.Signed();
+    m_Settings.lodPixels = reader.Float();
+    uint64_t fileCount = reader.Varint();
+    m_Settings.stickerFiles.clear();
+    for (uint64_t i = 0; i < fileCount && reader.ok; ++i)
+    {
+        m_Settings.stickerFiles.push_back(reader.String());
+    }
+    uint64_t count = reader.Varint();
+
+    m_Events.clear();
+    m_Cursor = 0;
+    uint64_t tick = 0;
+    for (uint64_t i = 0; i < count && reader.ok; ++i)
+    {
+        InputEvent event;
+        tick += reader.Varint();
+        event.tick = tick;
+        event.type = reader.Byte();
+        switch (event.type)
+        {
+            case InputEvent::Key:
+                event.code = reader.Signed();
+                event.action = reader.Byte();
+                event.mods = reader.Byte();
+                break;
+            case InputEvent::MouseButton:
+                event.code = reader.Byte();
+                event.action = reader.Byte();
+                event.mods = reader.Byte();
+                event.x = reader.Float();
+                event.y = reader.Float();
+                break;
+            default:
+                event.x = reader.Float();
+                event.y = reader.Float();
+                break;
+        }
+        if (reader.ok)
+        {
+            m_Events.push_back(event);
+        }
+    }
+
+    if (!reader.ok)
+    {
+        std::cout << "Input log is truncated: " << filepath << std::endl;
+    }
+    return reader.ok;
+}
+
+bool InputLog::Next(uint64_t tick, InputEvent& event)
+{
+    if (m_Cursor >= m_Events.size() || m_Events[m_Cursor].tick > tick)
+    {
+        return false;
+    }
+    event = m_Events[m_Cursor++];
+    return true;
+}
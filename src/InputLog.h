@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One input event as delivered by GLFW, stamped with the simulation tick it arrived on
+struct InputEvent
+{
+    enum Type : uint8_t
+    {
+        Key = 0,
+        MouseButton = 1,
+        CursorPos = 2,
+        Scroll = 3,
+        WindowSize = 4,
+        FramebufferSize = 5
+    };
+
+    uint64_t tick = 0;
+    uint8_t type = Key;
+    int code = 0;    // Key or mouse button
+    int action = 0;
+    int mods = 0;
+    float x = 0.0f;  // Cursor position (CursorPos, MouseButton), scroll offset or new size
+    float y = 0.0f;
+};
+
+// Records input events to a compact binary log and plays them back tick by tick.
+// Events are delta-encoded on the tick with LEB128 varints, most events take 3 to 10 bytes.
+class InputLog
+{
+    public:
+        // Every option that changes what the simulation, the renderer or the profiler see
+        struct Settings
+        {
+            float animationSpeed = 180.0f;
+            int animationMode = 0;
+            bool depthPrepass = false;
+            bool bufferStorage = true;
+            bool multiDraw = true;
+            int wallSize = 0;
+            float lodPixels = 24.0f;
+            std::vector<std::string> stickerFiles;
+            bool proceduralStickers = false;
+        };
+    private:
+        Settings m_Settings;
+        std::vector<InputEvent> m_Events;
+        size_t m_Cursor;
+    public:
+        InputLog();
+
+        void Record(const InputEvent& event);
+        bool Save(const std::string& filepath) const;
+        bool Load(const std::string& filepath);
+
+        // Pops the next event due at or before 'tick', in recorded order
+        bool Next(uint64_t tick, InputEvent& event);
+        inline bool IsFinished() const { return m_Cursor >= m_Events.size(); }
+
+        inline void SetSettings(const Settings& settings) { m_Settings = settings; }
+        inline const Settings& GetSettings() const { return m_Settings; }
+        inline size_t GetEventCount() const { return m_Events.size(); }
+};
@@ -0,0 +1,191 @@
+#include <MoveSequence.h>
+
+#include <cctype>
+#include <iostream>
+
+namespace
+{
+    struct FaceNotation
+    {
+        char name;
+        int axis;
+        int layer;
+        int turns; // Quarter turns about +axis for a clockwise turn seen from that face
+    };
+
+    const FaceNotation Faces[] = {
+        { 'R', 0,  1, -1 },
+        { 'L', 0, -1,  1 },
+        { 'U', 1,  1, -1 },
+        { 'D', 1, -1,  1 },
+        { 'F', 2,  1, -1 },
+        { 'B', 2, -1,  1 },
+        { 'M', 0,  0,  1 },
+        { 'E', 1,  0,  1 },
+        { 'S', 2,  0, -1 }
+    };
+
+    const FaceNotation* FindFace(char name)
+    {
+        for (const FaceNotation& face : Faces)
+        {
+            if (face.name == name)
+            {
+                return &face;
+            }
+        }
+        return nullptr;
+    }
+
+    const FaceNotation* FindFace(int axis, int layer)
+    {
+        for (const FaceNotation& face : Faces)
+        {
+            if (face.axis == axis && face.layer == layer)
+            {
+                return &face;
+            }
+        }
+        return nullptr;
+    }
+
+    struct PruningTable
+    {
+        uint32_t allowed[MoveSequence::FaceMoveCount + 1];
+
+        PruningTable()
+        {
+            uint32_t all = (1u << MoveSequence::FaceMoveCount) - 1;
+            allowed[0] = all;
+            for (int prev = 0; prev < MoveSequence::FaceMoveCount; ++prev)
+            {
+                CubeMove last = MoveSequence::FaceMove(prev);
+                uint32_t mask = 0;
+                for (int next = 0; next < MoveSequence::FaceMoveCount; ++next)
+                {
+                    CubeMove move = MoveSequence::FaceMove(next);
+                    if (move.axis == last.axis && move.layer <= last.layer)
+                    {
+                        continue;
+                    }
+                    mask |= 1u << next;
+                }
+                allowed[prev + 1] = mask;
+            }
+        }
+    };
+}
+
+bool MoveSequence::Parse(const std::string& text, std::vector<CubeMove>& moves)
+{
+    moves.clear();
+    size_t i = 0;
+    while (i < text.size())
+    {
+        char c = text[i];
+        if (std::isspace(static_cast<unsigned char>(c)) || c == ',')
+        {
+            ++i;
+            continue;
+        }
+
+        const FaceNotation* face = FindFace(static_cast<char>(std::toupper(static_cast<unsigned char>(c))));
+        if (!face)
+        {
+            std::cout << "Unknown move '" << c << "' in sequence: " << text << std::endl;
+            return false;
+        }
+        ++i;
+
+        CubeMove move;
+        move.axis = face->axis;
+        move.layer = face->layer;
+        move.turns = face->turns;
+        while (i < text.size() && (text[i] == '2' || text[i] == '\''))
+        {
+            move.turns = (text[i] == '2') ? 2 : -move.turns;
+            ++i;
+        }
+        moves.push_back(move);
+    }
+    return true;
+}
+
+std::string MoveSequence::ToString(const std::vector<CubeMove>& moves)
+{
+    std::string result;
+    for (const CubeMove& move : moves)
+    {
+        const FaceNotation* face = FindFace(move.axis, move.layer);
+        int turns = NormalizeTurns(move.turns);
+        if (!face || turns == 0)
+        {
+            continue;
+        }
+        if (!result.empty())
+        {
+            result += ' ';
+        }
+        result += face->name;
+        if (turns == 2)
+        {
+            result += '2';
+        }
+        else if (turns != face->turns)
+        {
+            result += '\'';
+        }
+    }
+    return result;
+}
+
+std::vector<CubeMove> MoveSequence::Simplify(const std::vector<CubeMove>& moves)
+{
+    std::vector<CubeMove> result;
+    result.reserve(moves.size());
+    for (const CubeMove& move : moves)
+    {
+        Append(result, move);
+    }
+    return result;
+}
+
+int MoveSequence::NormalizeTurns(int turns)
+{
+    turns = ((turns % 4) + 4) % 4;
+    return turns == 3 ? -1 : turns;
+}
+
+CubeMove MoveSequence::FaceMove(int index)
+{
+    // Index = face * 3 + variant, faces in R L U D F B order, variants {quarter, half, inverse}
+    static const int Variants[3] = { 1, 2, -1 };
+    const FaceNotation& face = Faces[index / 3];
+
+    CubeMove move;
+    move.axis = face.axis;
+    move.layer = face.layer;
+    move.turns = Variants[index % 3] == 2 ? 2 : face.turns * Variants[index % 3];
+    return move;
+}
+
+int MoveSequence::FaceMoveIndex(const CubeMove& move)
+{
+    int turns = NormalizeTurns(move.turns);
+    for (int face = 0; face < 6; ++face)
+    {
+        if (Faces[face].axis != move.axis || Faces[face].layer != move.layer || turns == 0)
+        {
+            continue;
+        }
+        int variant = turns == 2 ? 1 : (turns == Faces[face].turns ? 0 : 2);
+        return face * 3 + variant;
+    }
+    return -1;
+}
+
+uint32_t MoveSequence::AllowedAfter(int previous)
+{
+    static const PruningTable table;
+    return table.allowed[previous + 1];
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <CubeState.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Move notation, simplification and canonical move pruning.
+// Notation: R L U D F B (outer faces) and M E S (middle slices), with ' for inverse and 2 for a half turn.
+class MoveSequence
+{
+    public:
+        // The 18 outer face turns used by search (6 faces x {quarter, half, inverse})
+        static constexpr int FaceMoveCount = 18;
+    public:
+        static bool Parse(const std::string& text, std::vector<CubeMove>& moves);
+        static std::string ToString(const std::vector<CubeMove>& moves);
+
+        // Cancels inverses, merges same-layer turns mod 4 and orders commuting layers of one axis by layer
+        static std::vector<CubeMove> Simplify(const std::vector<CubeMove>& moves);
+
+        // Appends a move to an already simplified sequence, keeping it simplified
+        template<typename Sequence>
+        static void Append(Sequence& sequence, CubeMove move);
+
+        static int NormalizeTurns(int turns);
+
+        static CubeMove FaceMove(int index);
+        static int FaceMoveIndex(const CubeMove& move);
+
+        // Bit i is set if FaceMove(i) may follow 'previous' (-1 for the first move) in a canonical sequence.
+        // Same-face repeats and the descending order of opposite faces are pruned (18 -> ~13.35 branching).
+        static uint32_t AllowedAfter(int previous);
+};
+
+template<typename Sequence>
+void MoveSequence::Append(Sequence& sequence, CubeMove move)
+{
+    // A half turn keeps its sign so playback still rotates in the requested direction
+    int normalized = NormalizeTurns(move.turns);
+    if (normalized == 0)
+    {
+        return;
+    }
+    if (normalized != 2)
+    {
+        move.turns = normalized;
+    }
+
+    // Turns of one axis commute, so look through the whole trailing run of that axis
+    size_t runStart = sequence.size();
+    while (runStart > 0 && sequence[runStart - 1].axis == move.axis)
+    {
+        --runStart;
+    }
+
+    for (size_t i = runStart; i < sequence.size(); ++i)
+    {
+        if (sequence[i].layer == move.layer)
+        {
+            int turns = NormalizeTurns(sequence[i].turns + move.turns);
+            if (turns == 0)
+            {
+                sequence.erase(sequence.begin() + i);
+            }
+            else
+            {
+                sequence[i].turns = turns;
+            }
+            return;
+        }
+    }
+
+    sequence.push_back(move);
+    std::sort(sequence.begin() + runStart, sequence.end(), [](const CubeMove& a, const CubeMove& b)
+    {
+        return a.layer < b.layer;
+    });
+}
@@ -0,0 +1,74 @@
+#include <Profiler.h>
+
+#include <algorithm>
+
+Profiler::Profiler()
+    : m_FrameStart(0.0)
+{
+}
+
+void Profiler::BeginFrame(double time)
+{
+    m_FrameStart = time;
+}
+
+void Profiler::EndFrame(double time)
+{
+    m_FrameTimes.push_back(static_cast<float>(time - m_FrameStart));
+}
+
+void Profiler::Reset()
+{
+    m_FrameTimes.clear();
+    m_Counters.clear();
+}
+
+void Profiler::AddCount(const std::string& name, uint64_t count)
+{
+    for (auto& counter : m_Counters)
+    {
+        if (counter.first == name)
+        {
+            counter.second += count;
+            return;
+        }
+    }
+    m_Counters.emplace_back(name, count);
+}
+
+void Profiler::Report(std::ostream& stream) const
+{
+    if (m_FrameTimes.empty())
+    {
+        stream << "Profiler: no frames recorded" << std::endl;
+        return;
+    }
+
+    std::vector<float> sorted = m_FrameTimes;
+    std::sort(sorted.begin(), sorted.end());
+
+    double total = 0.0;
+    for (float t : sorted)
+    {
+        total += t;
+    }
+    auto percentile = [&sorted](double p)
+    {
+        size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[index] * 1000.0f;
+    };
+
+    stream << "Frames: " << sorted.size()
+        << ", total " << total << " s"
+        << ", avg " << (total / sorted.size()) * 1000.0 << " ms"
+        << ", p50 " << percentile(0.50) << " ms"
+        << ", p95 " << percentile(0.95) << " ms"
+        << ", p99 " << percentile(0.99) << " ms"
+        << ", max " << sorted.back() * 1000.0f << " ms" << std::endl;
+
+    for (const auto& counter : m_Counters)
+    {
+        stream << counter.first << ": " << counter.second
+            << " (" << static_cast<double>(counter.second) / sorted.size() << " per frame)" << std::endl;
+    }
+}
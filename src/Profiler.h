@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Collects per-frame CPU times and reports their distribution, along with named event counters
+class Profiler
+{
+    private:
+        std::vector<float> m_FrameTimes;
+        double m_FrameStart;
+        std::vector<std::pair<std::string, uint64_t>> m_Counters;
+    public:
+        Profiler();
+
+        void BeginFrame(double time);
+        void EndFrame(double time);
+        void Reset();
+
+        // Adds to a named counter, reported as a total and per frame
+        void AddCount(const std::string& name, uint64_t count);
+
+        void Report(std::ostream& stream) const;
+        inline size_t GetFrameCount() const { return m_FrameTimes.size(); }
+};
@@ -0,0 +1,243 @@
+#include <Renderer.h>
+
+#include <GLExtensions.h>
+
+#include <algorithm>
+
+namespace
+{
+    // Room for a few frames of a full cube wall before the stream buffers have to grow
+    const size_t InitialInstanceBufferSize = 4096 * sizeof(InstanceData);
+    const size_t InitialIndirectBufferSize = 1024 * sizeof(DrawElementsIndirectCommand);
+
+    bool SameRange(const MeshRange& a, const MeshRange& b)
+    {
+        return a.firstIndex == b.firstIndex && a.indexCount == b.indexCount && a.baseVertex == b.baseVertex;
+    }
+}
+
+Renderer::Renderer()
+    : m_InstanceBuffer(GL_ARRAY_BUFFER, InitialInstanceBufferSize), m_ViewProjection(1.0f)
+{
+    m_InstanceLayout.Push<float>(4);         // model matrix, one vec4 column per location
+    m_InstanceLayout.Push<float>(4);
+    m_InstanceLayout.Push<float>(4);
+    m_InstanceLayout.Push<float>(4);
+    m_InstanceLayout.Push<unsigned int>(1);  // facePalette
+    m_InstanceLayout.Push<unsigned int>(1);  // pickId
+    m_InstanceLayout.Push<unsigned int>(1);  // style
+
+    if (GLExtensions::MultiDrawIndirect)
+    {
+        m_IndirectBuffer = std::make_unique<StreamBuffer>(GL_DRAW_INDIRECT_BUFFER, InitialIndirectBufferSize);
+    }
+}
+
+void Renderer::Begin(const glm::mat4& viewProjection)
+{
+    m_ViewProjection = viewProjection;
+    m_Commands.clear();
+    m_Instances.clear();
+}
+
+void Renderer::Submit(Shader& shader, const VertexArray& va, const IndexBuffer& ib, const Texture* texture, const InstanceData& instance, float depth)
+{
+    Submit(shader, va, ib, MeshRange(), texture, instance, depth);
+}
+
+void Renderer::Submit(Shader& shader, const VertexArray& va, const IndexBuffer& ib, const MeshRange& range, const Texture* texture, const InstanceData& instance, float depth)
+{
+    DrawCommand command;
+    command.sortKey = MakeSortKey(shader, va, texture, range, depth);
+    command.shader = &shader;
+    command.vertexArray = &va;
+    command.indexBuffer = &ib;
+    command.texture = texture;
+    command.range = range;
+    if (command.range.indexCount == 0)
+    {
+        command.range.indexCount = ib.GetCount() - range.firstIndex;
+    }
+    command.instance = static_cast<uint32_t>(m_Instances.size());
+    m_Commands.push_back(command);
+    m_Instances.push_back(instance);
+}
+
+void Renderer::Flush()
+{
+    if (m_Commands.empty())
+    {
+        return;
+    }
+
+    SortCommands();
+    UploadInstances();
+    BuildBatches();
+
+    size_t indirectBase = 0;
+    if (m_IndirectBuffer)
+    {
+        size_t size = m_Draws.size() * sizeof(DrawElementsIndirectCommand);
+        std::copy(m_Draws.begin(), m_Draws.end(), static_cast<DrawElementsIndirectCommand*>(m_IndirectBuffer->Map(size)));
+        m_IndirectBuffer->Unmap();
+        indirectBase = m_IndirectBuffer->GetOffset();
+    }
+
+    const Shader* boundShader = nullptr;
+    for (const Batch& batch : m_Batches)
+    {
+        const DrawCommand& command = m_Commands[m_SortEntries[batch.first].command];
+        if (command.shader != boundShader)
+        {
+            command.shader->Bind();
+            command.shader->SetUniformMat4f("u_ViewProjection", m_ViewProjection);
+            boundShader = command.shader;
+        }
+        // The element buffer binding is vertex array state
+        command.vertexArray->Bind();
+        command.indexBuffer->Bind();
+        if (command.texture)
+        {
+            command.texture->Bind();
+        }
+        DrawBatch(batch, m_InstanceBuffer.GetOffset(), indirectBase);
+    }
+    m_InstanceBuffer.Fence();
+    if (m_IndirectBuffer)
+    {
+        m_IndirectBuffer->Fence();
+    }
+
+    m_Stats.commands += m_Commands.size();
+    m_Commands.clear();
+    m_Instances.clear();
+}
+
+uint64_t Renderer::MakeSortKey(const Shader& shader, const VertexArray& va, const Texture* texture, const MeshRange& range, float depth)
+{
+    // 12 bits per name; a collision only costs batching, never correctness
+    uint64_t program = shader.GetRendererID() & 0xFFF;
+    uint64_t mesh = va.GetRendererID() & 0xFFF;
+    uint64_t image = texture ? texture->GetRendererID() & 0xFFF : 0;
+    uint64_t part = range.firstIndex & 0xFFF;
+    uint64_t z = static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * 65535.0f);
+    return (program << 52) | (mesh << 40) | (image << 28) | (part << 16) | z;
+}
+
+void Renderer::SortCommands()
+{
+    size_t count = m_Commands.size();
+    m_SortEntries.resize(count);
+    m_SortScratch.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        m_SortEntries[i] = { m_Commands[i].sortKey, static_cast<uint32_t>(i) };
+    }
+
+    // LSD radix sort, 8 bits per pass; stable, and passes where every key has the same byte are skipped
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        size_t offsets[257] = {};
+        for (const SortEntry& entry : m_SortEntries)
+        {
+            offsets[((entry.key >> shift) & 0xFF) + 1]++;
+        }
+        if (offsets[((m_SortEntries[0].key >> shift) & 0xFF) + 1] == count)
+        {
+            continue;
+        }
+        for (int i = 0; i < 256; ++i)
+        {
+            offsets[i + 1] += offsets[i];
+        }
+        for (const SortEntry& entry : m_SortEntries)
+        {
+            m_SortScratch[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+        }
+        m_SortEntries.swap(m_SortScratch);
+    }
+}
+
+void Renderer::UploadInstances()
+{
+    // Written straight into the stream buffer in execution order, so every run is a contiguous range
+    size_t count = m_SortEntries.size();
+    InstanceData* instances = static_cast<InstanceData*>(m_InstanceBuffer.Map(count * sizeof(InstanceData)));
+    for (size_t i = 0; i < count; ++i)
+    {
+        instances[i] = m_Instances[m_Commands[m_SortEntries[i].command].instance];
+    }
+    m_InstanceBuffer.Unmap();
+}
+
+void Renderer::BuildBatches()
+{
+    m_Batches.clear();
+    m_Draws.clear();
+
+    size_t count = m_SortEntries.size();
+    for (size_t first = 0; first < count; )
+    {
+        const DrawCommand& command = m_Commands[m_SortEntries[first].command];
+        Batch batch = { first, first, m_Draws.size(), 0 };
+
+        // Extend the batch while only the mesh range and the instance data change, and merge
+        // consecutive commands drawing the same range into one instanced draw
+        while (batch.last < count)
+        {
+            const DrawCommand& next = m_Commands[m_SortEntries[batch.last].command];
+            if (next.shader != command.shader || next.vertexArray != command.vertexArray
+                || next.indexBuffer != command.indexBuffer || next.texture != command.texture)
+            {
+                break;
+            }
+
+            if (batch.drawCount > 0 && SameRange(next.range, m_Commands[m_SortEntries[batch.last - 1].command].range))
+            {
+                m_Draws.back().instanceCount++;
+            }
+            else
+            {
+                DrawElementsIndirectCommand draw;
+                draw.count = next.range.indexCount;
+                draw.instanceCount = 1;
+                draw.firstIndex = next.range.firstIndex;
+                draw.baseVertex = next.range.baseVertex;
+                draw.baseInstance = static_cast<uint32_t>(batch.last);
+                m_Draws.push_back(draw);
+                batch.drawCount++;
+            }
+            ++batch.last;
+        }
+
+        m_Batches.push_back(batch);
+        first = batch.last;
+    }
+}
+
+void Renderer::DrawBatch(const Batch& batch, size_t instanceBase, size_t indirectBase)
+{
+    const VertexArray& va = *m_Commands[m_SortEntries[batch.first].command].vertexArray;
+    m_InstanceBuffer.Bind();
+
+    if (m_IndirectBuffer)
+    {
+        // Instance attributes point at the start of this frame's data; baseInstance selects each range
+        va.SetAttributes(m_InstanceLayout, InstanceAttributeLocation, instanceBase, 1);
+        m_IndirectBuffer->Bind();
+        const void* indirect = reinterpret_cast<const void*>(indirectBase + batch.firstDraw * sizeof(DrawElementsIndirectCommand));
+        GLCall(GLExtensions::MultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, indirect, static_cast<GLsizei>(batch.drawCount), 0));
+        m_Stats.drawCalls++;
+        return;
+    }
+
+    // GL 3.3 has no base instance, so the instance attributes are pointed at every range instead
+    for (size_t i = batch.firstDraw; i < batch.firstDraw + batch.drawCount; ++i)
+    {
+        const DrawElementsIndirectCommand& draw = m_Draws[i];
+        va.SetAttributes(m_InstanceLayout, InstanceAttributeLocation, instanceBase + draw.baseInstance * sizeof(InstanceData), 1);
+        const void* indices = reinterpret_cast<const void*>(static_cast<uintptr_t>(draw.firstIndex) * sizeof(unsigned int));
+        GLCall(glDrawElementsInstancedBaseVertex(GL_TRIANGLES, draw.count, GL_UNSIGNED_INT, indices, draw.instanceCount, draw.baseVertex));
+        m_Stats.drawCalls++;
+    }
+}
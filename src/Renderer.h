@@ -0,0 +1,126 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <IndexBuffer.h>
+#include <Shader.h>
+#include <StreamBuffer.h>
+#include <Texture.h>
+#include <VertexArray.h>
+#include <VertexBufferLayout.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Per-instance attributes read by the INSTANCED shader variant (locations 4-10)
+struct InstanceData
+{
+    // EncodePickId wraps it to the background color, for geometry that can't be picked
+    static constexpr uint32_t NoPickId = 0xFFFFFFFFu;
+
+    glm::mat4 model;
+    uint32_t facePalette;
+    uint32_t pickId;
+    uint32_t style;  // Layer of the sticker texture array
+};
+
+// Part of an index buffer, so several meshes can share one vertex array and be drawn together
+struct MeshRange
+{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;  // 0 draws up to the end of the index buffer
+    int32_t baseVertex = 0;
+};
+
+// One recorded draw: material (shader + texture), mesh and instance data
+struct DrawCommand
+{
+    uint64_t sortKey;
+    Shader* shader;
+    const VertexArray* vertexArray;
+    const IndexBuffer* indexBuffer;
+    const Texture* texture;
+    MeshRange range;
+    uint32_t instance;  // Index into the submitted instance data
+};
+
+// Layout fixed by GL for glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    uint32_t baseInstance;
+};
+
+// Command bucket renderer. Draws are recorded between Begin() and Flush(), radix sorted by their
+// state and executed with one bind per state change; consecutive commands sharing shader, mesh and
+// texture are merged into a single instanced draw. Commands that only differ in their MeshRange become
+// one glMultiDrawElementsIndirect call when the driver supports it, and a loop of instanced draws
+// otherwise. Shaders must be built with the INSTANCED define and get the u_ViewProjection uniform
+// from Begin().
+class Renderer
+{
+    public:
+        static const unsigned int InstanceAttributeLocation = 4;
+
+        struct Stats
+        {
+            uint64_t commands = 0;
+            uint64_t drawCalls = 0;
+        };
+    private:
+        struct SortEntry
+        {
+            uint64_t key;
+            uint32_t command;
+        };
+
+        // Sorted commands [first, last) sharing all bound state, drawn by 'drawCount' indirect commands
+        struct Batch
+        {
+            size_t first;
+            size_t last;
+            size_t firstDraw;
+            size_t drawCount;
+        };
+
+        std::vector<DrawCommand> m_Commands;
+        std::vector<InstanceData> m_Instances;
+        std::vector<SortEntry> m_SortEntries;
+        std::vector<SortEntry> m_SortScratch;
+        std::vector<Batch> m_Batches;
+        std::vector<DrawElementsIndirectCommand> m_Draws;
+
+        VertexBufferLayout m_InstanceLayout;
+        StreamBuffer m_InstanceBuffer;
+        std::unique_ptr<StreamBuffer> m_IndirectBuffer;  // Only when multi-draw indirect is available
+        glm::mat4 m_ViewProjection;
+        Stats m_Stats;
+    public:
+        Renderer();
+
+        Renderer(const Renderer&) = delete;
+        Renderer& operator=(const Renderer&) = delete;
+
+        void Begin(const glm::mat4& viewProjection);
+        // 'depth' in [0, 1] orders commands with equal state front to back
+        void Submit(Shader& shader, const VertexArray& va, const IndexBuffer& ib, const Texture* texture, const InstanceData& instance, float depth = 0.0f);
+        void Submit(Shader& shader, const VertexArray& va, const IndexBuffer& ib, const MeshRange& range, const Texture* texture, const InstanceData& instance, float depth = 0.0f);
+        void Flush();
+
+        inline const Stats& GetStats() const { return m_Stats; }
+        inline void ResetStats() { m_Stats = Stats(); }
+
+        // Program, then mesh, then texture (most to least expensive to switch), then mesh range so each
+        // range is one contiguous run, then depth. Bits 63-52 program, 51-40 VAO, 39-28 texture and
+        // 27-16 first index hold the low 12 bits of each name; bits 15-0 are the quantized depth.
+        static uint64_t MakeSortKey(const Shader& shader, const VertexArray& va, const Texture* texture, const MeshRange& range, float depth);
+    private:
+        void SortCommands();
+        void UploadInstances();
+        void BuildBatches();
+        void DrawBatch(const Batch& batch, size_t instanceBase, size_t indirectBase);
+};
@@ -1,8 +1,11 @@
 #include <RubiksCube.h>
+#include <MoveSequence.h>
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
 
 RubiksCube::RubiksCube(float spacing)
     : m_Spacing(spacing)
@@ -35,58 +38,117 @@ void RubiksCube::Initialize()
                 cube.orientation = glm::mat3(1.0f);
                 cube.manualTranslation = glm::vec3(0.0f);
                 cube.manualRotation = glm::mat3(1.0f);
-                for (int i = 0; i < 6; ++i)
-                {
-                    cube.faceColor[i] = glm::vec3(0.0f);
-                }
+                int colors[6] = { ColorNone, ColorNone, ColorNone, ColorNone, ColorNone, ColorNone };
                 if (x == 1)
                 {
-                    cube.faceColor[0] = glm::vec3(1.0f, 0.0f, 0.0f);
+                    colors[0] = ColorRed;
                 }
                 if (x == -1)
                 {
-                    cube.faceColor[1] = glm::vec3(1.0f, 0.5f, 0.0f);
+                    colors[1] = ColorOrange;
                 }
                 if (y == 1)
                 {
-                    cube.faceColor[2] = glm::vec3(1.0f);
+                    colors[2] = ColorWhite;
                 }
                 if (y == -1)
                 {
-                    cube.faceColor[3] = glm::vec3(1.0f, 1.0f, 0.0f);
+                    colors[3] = ColorYellow;
                 }
                 if (z == 1)
                 {
-                    cube.faceColor[4] = glm::vec3(0.0f, 1.0f, 0.0f);
+                    colors[4] = ColorGreen;
                 }
                 if (z == -1)
                 {
-                    cube.faceColor[5] = glm::vec3(0.0f, 0.0f, 1.0f);
+                    colors[5] = ColorBlue;
+                }
+                cube.facePalette = 0;
+                for (int i = 0; i < 6; ++i)
+                {
+                    cube.facePalette |= static_cast<uint32_t>(colors[i]) << (FaceBits * i);
                 }
                 m_Cubes.push_back(cube);
             }
         }
     }
     RebuildMapping();
+    m_StateHash = ComputeStateHash();
 }
 
 void RubiksCube::Update(float deltaTime)
 {
-    if (!m_Rotation.active)
+    m_Rotation.previousAngleDeg = m_Rotation.angleDeg;
+
+    if (m_AnimationMode == AnimationInstant)
     {
+        if (m_Rotation.active)
+        {
+            CompleteRotation();
+        }
+        while (!m_MoveQueue.empty())
+        {
+            StartNextQueuedMove();
+            CompleteRotation();
+        }
         return;
     }
 
-    const float rotationSpeed = 180.0f;
-    m_Rotation.angleDeg += rotationSpeed * deltaTime;
-    if (m_Rotation.angleDeg >= m_Rotation.targetDeg - 0.0001f)
+    // Time left over after a turn completes carries into the next queued turn,
+    // so long sequences play at the same rate regardless of frame rate
+    float remaining = deltaTime;
+    while (remaining > 0.0f)
     {
-        m_Rotation.angleDeg = m_Rotation.targetDeg;
-        ApplyCompletedRotation();
-        m_Rotation.active = false;
+        if (!m_Rotation.active)
+        {
+            StartNextQueuedMove();
+            if (!m_Rotation.active)
+            {
+                return;
+            }
+        }
+
+        const float rotationSpeed = CurrentAnimationSpeed();
+        float degreesLeft = m_Rotation.targetDeg - m_Rotation.angleDeg;
+        float step = rotationSpeed * remaining;
+        if (step < degreesLeft - 0.0001f)
+        {
+            m_Rotation.angleDeg += step;
+            return;
+        }
+
+        remaining -= degreesLeft / rotationSpeed;
+        CompleteRotation();
     }
 }
 
+void RubiksCube::CompleteRotation()
+{
+    m_Rotation.angleDeg = m_Rotation.targetDeg;
+    ApplyCompletedRotation();
+    m_Rotation.active = false;
+}
+
+float RubiksCube::CurrentAnimationSpeed() const
+{
+    if (m_AnimationMode != AnimationAdaptive)
+    {
+        return m_AnimationSpeed;
+    }
+
+    float pendingDeg = m_Rotation.active ? m_Rotation.targetDeg - m_Rotation.angleDeg : 0.0f;
+    for (const CubeMove& move : m_MoveQueue)
+    {
+        pendingDeg += 90.0f * std::abs(move.turns);
+    }
+    return std::max(m_AnimationSpeed, pendingDeg / AdaptiveCatchUpSeconds);
+}
+
+void RubiksCube::SetAnimationSpeed(float degreesPerSecond)
+{
+    m_AnimationSpeed = std::max(1.0f, degreesPerSecond);
+}
+
 bool RubiksCube::StartRotation(Axis axis, int layer, int direction, float degrees)
 {
     if (m_Rotation.active)
@@ -99,6 +161,7 @@ bool RubiksCube::StartRotation(Axis axis, int layer, int direction, float degree
     m_Rotation.layer = layer;
     m_Rotation.direction = direction >= 0 ? 1 : -1;
     m_Rotation.angleDeg = 0.0f;
+    m_Rotation.previousAngleDeg = 0.0f;
     m_Rotation.targetDeg = degrees;
     return true;
 }
@@ -108,7 +171,38 @@ bool RubiksCube::IsRotating() const
     return m_Rotation.active;
 }
 
-glm::mat4 RubiksCube::GetCubeModel(int id) const
+void RubiksCube::QueueMove(const CubeMove& move)
+{
+    MoveSequence::Append(m_MoveQueue, move);
+}
+
+void RubiksCube::QueueMoves(const std::vector<CubeMove>& moves)
+{
+    for (const CubeMove& move : moves)
+    {
+        MoveSequence::Append(m_MoveQueue, move);
+    }
+}
+
+void RubiksCube::ClearQueuedMoves()
+{
+    m_MoveQueue.clear();
+}
+
+void RubiksCube::StartNextQueuedMove()
+{
+    if (m_Rotation.active || m_MoveQueue.empty())
+    {
+        return;
+    }
+
+    CubeMove move = m_MoveQueue.front();
+    m_MoveQueue.pop_front();
+    int direction = move.turns >= 0 ? 1 : -1;
+    StartRotation(static_cast<Axis>(move.axis), move.layer, direction, 90.0f * std::abs(move.turns));
+}
+
+glm::mat4 RubiksCube::GetCubeModel(int id, float alpha) const
 {
     if (id < 0 || id >= static_cast<int>(m_Cubes.size()))
     {
@@ -121,7 +215,7 @@ glm::mat4 RubiksCube::GetCubeModel(int id) const
 
     if (m_Rotation.active && IsCubeInLayer(cube))
     {
-        glm::mat3 rot = RotationMatrix(m_Rotation.axis, m_Rotation.direction * m_Rotation.angleDeg);
+        glm::mat3 rot = LayerRotation(alpha);
         pos = rot * pos;
         orient = rot * orient;
     }
@@ -134,6 +228,29 @@ glm::mat4 RubiksCube::GetCubeModel(int id) const
     return model;
 }
 
+void RubiksCube::PublishSnapshot(float alpha)
+{
+    Snapshot& snapshot = m_Snapshots.GetWriteBuffer();
+    snapshot.sequence = ++m_SnapshotSequence;
+    snapshot.stateHash = m_StateHash;
+    snapshot.rotation = m_Rotation;
+    snapshot.cubeCount = std::min(static_cast<int>(m_Cubes.size()), CubeState::CubieCount);
+    snapshot.cubieRadius = 0.5f * std::sqrt(3.0f) * m_CubeScale;
+    snapshot.boundsRadius = 0.0f;
+    snapshot.intact = true;
+    for (int i = 0; i < snapshot.cubeCount; ++i)
+    {
+        snapshot.models[i] = GetCubeModel(m_Cubes[i].id, alpha);
+        snapshot.facePalettes[i] = m_Cubes[i].facePalette;
+        snapshot.boundsRadius = std::max(snapshot.boundsRadius, glm::length(glm::vec3(snapshot.models[i][3])) + snapshot.cubieRadius);
+        snapshot.intact = snapshot.intact && m_Cubes[i].manualTranslation == glm::vec3(0.0f)
+            && m_Cubes[i].manualRotation == glm::mat3(1.0f);
+    }
+    BuildBodies(snapshot, alpha);
+    BuildFacelets(snapshot);
+    m_Snapshots.Publish();
+}
+
 glm::vec3 RubiksCube::GetCubeCenterWorld(int id) const
 {
     if (id < 0 || id >= static_cast<int>(m_Cubes.size()))
@@ -168,13 +285,28 @@ void RubiksCube::RotateCubeManual(int id, const glm::mat3& rotation)
     cube.manualRotation = rotation * cube.manualRotation;
 }
 
-const glm::vec3* RubiksCube::GetCubeFaceColors(int id) const
+uint32_t RubiksCube::GetCubeFacePalette(int id) const
 {
     if (id < 0 || id >= static_cast<int>(m_Cubes.size()))
     {
-        return nullptr;
+        return 0;
     }
-    return m_Cubes[id].faceColor;
+    return m_Cubes[id].facePalette;
+}
+
+const std::array<glm::vec4, RubiksCube::PaletteSize>& RubiksCube::GetPalette()
+{
+    static const std::array<glm::vec4, PaletteSize> palette = {
+        glm::vec4(0.0f, 0.0f, 0.0f, 1.0f),  // ColorNone (inner faces)
+        glm::vec4(1.0f, 0.0f, 0.0f, 1.0f),  // ColorRed
+        glm::vec4(1.0f, 0.5f, 0.0f, 1.0f),  // ColorOrange
+        glm::vec4(1.0f, 1.0f, 1.0f, 1.0f),  // ColorWhite
+        glm::vec4(1.0f, 1.0f, 0.0f, 1.0f),  // ColorYellow
+        glm::vec4(0.0f, 1.0f, 0.0f, 1.0f),  // ColorGreen
+        glm::vec4(0.0f, 0.0f, 1.0f, 1.0f),  // ColorBlue
+        glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)   // Unused
+    };
+    return palette;
 }
 
 bool RubiksCube::IsCubeInLayer(const CubeInstance& cube) const
@@ -192,6 +324,71 @@ bool RubiksCube::IsCubeInLayer(const CubeInstance& cube) const
     }
 }
 
+glm::mat3 RubiksCube::LayerRotation(float alpha) const
+{
+    float angleDeg = m_Rotation.previousAngleDeg + (m_Rotation.angleDeg - m_Rotation.previousAngleDeg) * alpha;
+    return RotationMatrix(m_Rotation.axis, m_Rotation.direction * angleDeg);
+}
+
+void RubiksCube::BuildBodies(Snapshot& snapshot, float alpha) const
+{
+    snapshot.bodyCount = 0;
+    if (!snapshot.intact)
+    {
+        return;
+    }
+
+    // Halfway down the gaps between cubies: the bodies fill the gaps in black like the sides of the cubies did,
+    // and sit as far below the sticker planes as the cube's proportions allow, so they keep clear of the
+    // stickers in depth even with the far plane pushed out for a wall
+    const float inset = 0.5f * (m_Spacing - m_CubeScale);
+    float outer = 2.0f * (m_Spacing + 0.5f * m_CubeScale - inset);
+    if (!m_Rotation.active)
+    {
+        snapshot.bodyModels[0] = glm::scale(glm::mat4(1.0f), glm::vec3(outer));
+        snapshot.bodyCount = 1;
+        return;
+    }
+
+    // Slabs along the turning axis, the turning one rotated like its cubies
+    glm::vec3 axis(0.0f);
+    axis[m_Rotation.axis] = 1.0f;
+    glm::vec3 size = glm::vec3(outer) + axis * (m_CubeScale - 2.0f * inset - outer);
+    glm::mat4 rotation = glm::mat4(LayerRotation(alpha));
+    for (int layer = -1; layer <= 1; ++layer)
+    {
+        glm::mat4 slab = glm::translate(glm::mat4(1.0f), axis * (m_Spacing * layer)) * glm::scale(glm::mat4(1.0f), size);
+        snapshot.bodyModels[snapshot.bodyCount++] = layer == m_Rotation.layer ? rotation * slab : slab;
+    }
+}
+
+void RubiksCube::BuildFacelets(Snapshot& snapshot) const
+{
+    snapshot.boxModel = glm::scale(glm::mat4(1.0f), glm::vec3(2.0f * m_Spacing + m_CubeScale));
+    snapshot.facelets.fill(ColorNone);
+    for (const CubeInstance& cube : m_Cubes)
+    {
+        for (int face = 0; face < 6; ++face)
+        {
+            int color = GetFacePaletteIndex(cube.facePalette, face);
+            if (color == ColorNone)
+            {
+                continue;
+            }
+
+            // Where the sticker points after the cubie's turns decides the puzzle face it is on
+            glm::vec3 local(0.0f);
+            local[face / 2] = face % 2 == 0 ? 1.0f : -1.0f;
+            glm::vec3 normal = glm::round(cube.orientation * local);
+            int axis = std::abs(normal.x) > 0.5f ? 0 : (std::abs(normal.y) > 0.5f ? 1 : 2);
+            int outward = 2 * axis + (normal[axis] > 0.0f ? 0 : 1);
+            int a = cube.grid[axis == 0 ? 1 : 0] + 1;
+            int b = cube.grid[axis == 2 ? 1 : 2] + 1;
+            snapshot.facelets[outward * 9 + 3 * a + b] = static_cast<uint8_t>(color);
+        }
+    }
+}
+
 glm::mat3 RubiksCube::RotationMatrix(Axis axis, float angleDeg) const
 {
     glm::vec3 axisVec(0.0f);
@@ -231,8 +428,17 @@ void RubiksCube::ApplyCompletedRotation()
             static_cast<int>(std::round(rotated.z))
         );
 
+        m_StateHash ^= CubeState::ZobristKey(cube.id, CubeState::SlotIndex(cube.grid), OrientationIndexOf(cube));
         cube.grid = snapped;
         cube.orientation = rot * cube.orientation;
+
+        // Snap to the exact table rotation so repeated turns do not accumulate float drift
+        int orientation = CubeState::OrientationIndex(cube.orientation);
+        if (orientation >= 0)
+        {
+            cube.orientation = CubeState::OrientationMatrix(orientation);
+        }
+        m_StateHash ^= CubeState::ZobristKey(cube.id, CubeState::SlotIndex(cube.grid), OrientationIndexOf(cube));
     }
 
     RebuildMapping();
@@ -262,3 +468,30 @@ void RubiksCube::RebuildMapping()
         }
     }
 }
+
+uint64_t RubiksCube::ComputeStateHash() const
+{
+    uint64_t hash = 0;
+    for (const CubeInstance& cube : m_Cubes)
+    {
+        hash ^= CubeState::ZobristKey(cube.id, CubeState::SlotIndex(cube.grid), OrientationIndexOf(cube));
+    }
+    return hash;
+}
+
+CubeState RubiksCube::GetState() const
+{
+    CubeState state;
+    for (const CubeInstance& cube : m_Cubes)
+    {
+        state.SetCubie(cube.id, CubeState::SlotIndex(cube.grid), OrientationIndexOf(cube));
+    }
+    return state;
+}
+
+int RubiksCube::OrientationIndexOf(const CubeInstance& cube)
+{
+    // Turns are whole quarter turns, so the orientation is always one of the 24 cube rotations
+    int orientation = CubeState::OrientationIndex(cube.orientation);
+    return orientation >= 0 ? orientation : 0;
+}
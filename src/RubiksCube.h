@@ -2,7 +2,12 @@
 
 #include <glm/glm.hpp>
 
+#include <CubeState.h>
+#include <TripleBuffer.h>
+
 #include <array>
+#include <cstdint>
+#include <deque>
 #include <vector>
 
 class RubiksCube
@@ -15,6 +20,28 @@ public:
         AxisZ = 2
     };
 
+    // Sticker colors, stored per cubie face as a 3-bit index into the palette
+    enum PaletteColor
+    {
+        ColorNone = 0,
+        ColorRed = 1,
+        ColorOrange = 2,
+        ColorWhite = 3,
+        ColorYellow = 4,
+        ColorGreen = 5,
+        ColorBlue = 6
+    };
+    static constexpr int PaletteSize = 8;
+    static constexpr int FaceBits = 3;
+    static constexpr int FaceletCount = 6 * 9;
+
+    enum AnimationMode
+    {
+        AnimationNormal = 0,    // Fixed speed
+        AnimationAdaptive = 1,  // Speeds up so the queued moves finish within AdaptiveCatchUpSeconds
+        AnimationInstant = 2    // Applies moves without animating them
+    };
+
     struct CubeInstance
     {
         int id = -1;
@@ -22,7 +49,7 @@ public:
         glm::mat3 orientation = glm::mat3(1.0f);
         glm::vec3 manualTranslation = glm::vec3(0.0f);
         glm::mat3 manualRotation = glm::mat3(1.0f);
-        glm::vec3 faceColor[6];
+        uint32_t facePalette = 0;  // Face i (0..5 = +X -X +Y -Y +Z -Z) in bits [3i, 3i+3)
     };
 
     struct RotationState
@@ -32,9 +59,37 @@ public:
         int layer = 0;
         int direction = 1;
         float angleDeg = 0.0f;
+        float previousAngleDeg = 0.0f;
         float targetDeg = 90.0f;
     };
 
+    // Immutable copy of everything needed to draw the cube, safe to read from another thread
+    struct Snapshot
+    {
+        uint64_t sequence = 0;
+        uint64_t stateHash = 0;
+        RotationState rotation;
+        int cubeCount = 0;
+        std::array<glm::mat4, CubeState::CubieCount> models;
+        std::array<uint32_t, CubeState::CubieCount> facePalettes;
+
+        // Culling data in model space: a sphere around the whole puzzle and around each cubie
+        float boundsRadius = 0.0f;
+        float cubieRadius = 0.0f;
+
+        // While no cubie is dragged or spun out of place only stickers need drawing, in front of
+        // black bodies filling the puzzle: one box, or one slab per layer while a layer turns
+        bool intact = true;
+        int bodyCount = 0;
+        std::array<glm::mat4, 3> bodyModels;
+
+        // The whole puzzle for distant views: one box through the sticker planes, and the palette index of
+        // every sticker as face * 9 + 3 * (a + 1) + (b + 1), with a, b the grid coordinates along the face's
+        // other two axes in X, Y, Z order. Stickers follow the completed turns only, not a turn in progress.
+        glm::mat4 boxModel = glm::mat4(1.0f);
+        std::array<uint8_t, FaceletCount> facelets;
+    };
+
 public:
     explicit RubiksCube(float spacing = 1.06f);
 
@@ -43,11 +98,40 @@ public:
     bool StartRotation(Axis axis, int layer, int direction, float degrees);
     bool IsRotating() const;
 
-    glm::mat4 GetCubeModel(int id) const;
+    // Queued moves are simplified against the pending tail (R R' cancels, R R merges) and played in order
+    void QueueMove(const CubeMove& move);
+    void QueueMoves(const std::vector<CubeMove>& moves);
+    void ClearQueuedMoves();
+    size_t GetQueuedMoveCount() const { return m_MoveQueue.size(); }
+
+    void SetAnimationSpeed(float degreesPerSecond);
+    float GetAnimationSpeed() const { return m_AnimationSpeed; }
+    void SetAnimationMode(AnimationMode mode) { m_AnimationMode = mode; }
+    AnimationMode GetAnimationMode() const { return m_AnimationMode; }
+
+    // 'alpha' interpolates the turning layer between the previous and the current update
+    glm::mat4 GetCubeModel(int id, float alpha = 1.0f) const;
     glm::vec3 GetCubeCenterWorld(int id) const;
     void SetCubeCenterWorld(int id, const glm::vec3& center);
     void RotateCubeManual(int id, const glm::mat3& rotation);
-    const glm::vec3* GetCubeFaceColors(int id) const;
+    uint32_t GetCubeFacePalette(int id) const;
+
+    // RGBA palette, padded to vec4 so it can be uploaded as a std140 uniform block
+    static const std::array<glm::vec4, PaletteSize>& GetPalette();
+    static int GetFacePaletteIndex(uint32_t facePalette, int face)
+    {
+        return static_cast<int>((facePalette >> (FaceBits * face)) & (PaletteSize - 1));
+    }
+
+    // Zobrist hash of the logical puzzle state, updated incrementally per completed turn
+    uint64_t GetStateHash() const { return m_StateHash; }
+    CubeState GetState() const;
+
+    // Producer side (simulation thread): write the current state into a preallocated buffer, no allocations
+    void PublishSnapshot(float alpha = 1.0f);
+    // Consumer side (render thread): switch to the latest published snapshot, returns false if none is newer
+    bool AcquireSnapshot() { return m_Snapshots.Acquire(); }
+    const Snapshot& GetSnapshot() const { return m_Snapshots.GetReadBuffer(); }
 
     const std::vector<CubeInstance>& GetCubes() const { return m_Cubes; }
     const RotationState& GetRotationState() const { return m_Rotation; }
@@ -58,10 +142,25 @@ private:
     float m_Spacing = 1.06f;
     float m_CubeScale = 0.96f;
     RotationState m_Rotation;
+    uint64_t m_StateHash = 0;
+    std::deque<CubeMove> m_MoveQueue;
+    float m_AnimationSpeed = 180.0f;
+    AnimationMode m_AnimationMode = AnimationNormal;
+    static constexpr float AdaptiveCatchUpSeconds = 0.5f;
+    TripleBuffer<Snapshot> m_Snapshots;
+    uint64_t m_SnapshotSequence = 0;
 
 private:
     bool IsCubeInLayer(const CubeInstance& cube) const;
     glm::mat3 RotationMatrix(Axis axis, float angleDeg) const;
+    glm::mat3 LayerRotation(float alpha) const;
+    void BuildBodies(Snapshot& snapshot, float alpha) const;
+    void BuildFacelets(Snapshot& snapshot) const;
     void ApplyCompletedRotation();
     void RebuildMapping();
+    void StartNextQueuedMove();
+    void CompleteRotation();
+    float CurrentAnimationSpeed() const;
+    uint64_t ComputeStateHash() const;
+    static int OrientationIndexOf(const CubeInstance& cube);
 };
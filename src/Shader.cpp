@@ -1,31 +1,283 @@
 #include <Shader.h>
 
-Shader::Shader(const std::string& filepath)
-    : m_Filepath(filepath), m_RendererID(0)
+#include <GLExtensions.h>
+#include <GLStateCache.h>
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <vector>
+
+namespace
+{
+    const uint32_t BinaryCacheMagic = 0x42535243; // "CRSB"
+    const uint32_t BinaryCacheVersion = 1;
+
+    // Guards against include cycles
+    const int MaxIncludeDepth = 16;
+
+    struct BinaryCacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t sourceHash;
+        uint64_t driverHash;
+        uint32_t format;
+        uint32_t length;
+    };
+
+    // FNV-1a, stable across runs and platforms unlike std::hash
+    uint64_t HashString(const std::string& text)
+    {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (unsigned char c : text)
+        {
+            hash ^= c;
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    uint64_t HashSource(const ShaderProgramSource& source)
+    {
+        return HashString(source.VertexSource + '\0' + source.FragmentSource);
+    }
+}
+
+Shader::Shader(const std::string& filepath, const std::vector<std::string>& defines)
+    : m_Filepath(filepath), m_Defines(defines), m_RendererID(0), m_SourceHash(0), m_PendingProgram(0), m_PendingShaders{ 0, 0 }, m_PendingSourceHash(0)
 {
     ShaderProgramSource source = ParseShader(filepath);
-    m_RendererID = CreateShader(source.VertexSource, source.FragmentSource);
+    m_SourceHash = HashSource(source);
+    if (!GLExtensions::ProgramBinary)
+    {
+        m_RendererID = CreateShader(source.VertexSource, source.FragmentSource);
+        return;
+    }
+
+    // Reuse the driver's compiled program unless the source or the driver changed
+    uint64_t driverHash = HashString(GLExtensions::GetDriverString());
+    std::string cachePath = GetBinaryCachePath();
+
+    m_RendererID = LoadProgramBinary(cachePath, m_SourceHash, driverHash);
+    if (m_RendererID == 0)
+    {
+        m_RendererID = CreateShader(source.VertexSource, source.FragmentSource);
+        SaveProgramBinary(m_RendererID, cachePath, m_SourceHash, driverHash);
+    }
 }
 
 Shader::~Shader()
 {
+    m_Watchers.clear();
+    DiscardReload();
+    GLStateCache::ForgetProgram(m_RendererID);
     GLCall(glDeleteProgram(m_RendererID));
 }
 
-ShaderProgramSource Shader::ParseShader(const std::string& filepath)
+void Shader::EnableHotReload()
 {
-    std::ifstream stream(filepath);
+    if (m_Watchers.empty())
+    {
+        WatchDependencies();
+    }
+}
 
-    enum class ShaderType
+void Shader::WatchDependencies()
+{
+    m_Watchers.clear();
+    for (const std::string& dependency : m_Dependencies)
     {
-        NONE = -1, VERTEX = 0, FRAGMENT = 1
-    };
+        m_Watchers.push_back(std::make_unique<FileWatcher>(dependency));
+    }
+}
+
+bool Shader::PollReload()
+{
+    if (m_Watchers.empty())
+    {
+        return false;
+    }
+
+    bool changed = false;
+    for (auto& watcher : m_Watchers)
+    {
+        changed |= watcher->ConsumeChange();
+    }
+
+    // A newer save supersedes a build still in flight
+    if (changed)
+    {
+        std::vector<std::string> dependencies = m_Dependencies;
+        ShaderProgramSource source = ParseShader(m_Filepath);
+        if (m_Dependencies != dependencies)
+        {
+            WatchDependencies();
+        }
+
+        uint64_t sourceHash = HashSource(source);
+        DiscardReload();
+        if (sourceHash != m_SourceHash && !source.VertexSource.empty() && !source.FragmentSource.empty())
+        {
+            m_PendingSourceHash = sourceHash;
+            BeginReload(source);
+
+            // Never query the build on the frame that submitted it. Without parallel compilation
+            // the driver may still block on the status query next frame, but not on top of this one.
+            return false;
+        }
+    }
+
+    if (m_PendingProgram == 0)
+    {
+        return false;
+    }
+
+    // With parallel compilation the driver builds in the background; check back next frame
+    if (GLExtensions::ParallelShaderCompile)
+    {
+        int complete = GL_FALSE;
+        GLCall(glGetProgramiv(m_PendingProgram, GL_COMPLETION_STATUS, &complete));
+        if (complete == GL_FALSE)
+        {
+            return false;
+        }
+    }
+
+    int linked;
+    GLCall(glGetProgramiv(m_PendingProgram, GL_LINK_STATUS, &linked));
+    if (linked == GL_FALSE)
+    {
+        FinishReload();
+        DiscardReload();
+        return false;
+    }
+
+    FinishReload();
+    GLStateCache::ForgetProgram(m_RendererID);
+    GLCall(glDeleteProgram(m_RendererID));
+    m_RendererID = m_PendingProgram;
+    m_SourceHash = m_PendingSourceHash;
+    m_PendingProgram = 0;
+    m_UniformLocationCache.clear();
+
+    if (GLExtensions::ProgramBinary)
+    {
+        SaveProgramBinary(m_RendererID, GetBinaryCachePath(), m_SourceHash, HashString(GLExtensions::GetDriverString()));
+    }
+    std::cout << "Reloaded shader " << m_Filepath << std::endl;
+    return true;
+}
+
+void Shader::BeginReload(const ShaderProgramSource& source)
+{
+    // No status queries here: they would block until the compiler is done
+    GLCall(m_PendingProgram = glCreateProgram());
+    const unsigned int types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+    const std::string* sources[2] = { &source.VertexSource, &source.FragmentSource };
+    for (int i = 0; i < 2; ++i)
+    {
+        GLCall(m_PendingShaders[i] = glCreateShader(types[i]));
+        const char* src = sources[i]->c_str();
+        GLCall(glShaderSource(m_PendingShaders[i], 1, &src, nullptr));
+        GLCall(glCompileShader(m_PendingShaders[i]));
+        GLCall(glAttachShader(m_PendingProgram, m_PendingShaders[i]));
+    }
+    if (GLExtensions::ProgramBinary)
+    {
+        GLCall(GLExtensions::ProgramParameteri(m_PendingProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    }
+    GLCall(glLinkProgram(m_PendingProgram));
+}
+
+void Shader::FinishReload()
+{
+    // Report compile and link errors, then release the shader objects
+    for (unsigned int& shader : m_PendingShaders)
+    {
+        int compiled;
+        GLCall(glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled));
+        if (compiled == GL_FALSE)
+        {
+            int length;
+            GLCall(glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length));
+            std::vector<char> message(length + 1, '\0');
+            GLCall(glGetShaderInfoLog(shader, length, &length, message.data()));
+            std::cout << "Failed to compile " << (&shader == &m_PendingShaders[0] ? "vertex" : "fragment") << " shader" << std::endl;
+            std::cout << message.data() << std::endl;
+        }
+        GLCall(glDetachShader(m_PendingProgram, shader));
+        GLCall(glDeleteShader(shader));
+        shader = 0;
+    }
+
+    int linked;
+    GLCall(glGetProgramiv(m_PendingProgram, GL_LINK_STATUS, &linked));
+    if (linked == GL_FALSE)
+    {
+        int length;
+        GLCall(glGetProgramiv(m_PendingProgram, GL_INFO_LOG_LENGTH, &length));
+        std::vector<char> message(length + 1, '\0');
+        GLCall(glGetProgramInfoLog(m_PendingProgram, length, &length, message.data()));
+        std::cout << "Failed to reload " << m_Filepath << ", keeping the previous program" << std::endl;
+        std::cout << message.data() << std::endl;
+    }
+}
+
+void Shader::DiscardReload()
+{
+    for (unsigned int& shader : m_PendingShaders)
+    {
+        if (shader != 0)
+        {
+            GLCall(glDeleteShader(shader));
+            shader = 0;
+        }
+    }
+    if (m_PendingProgram != 0)
+    {
+        GLCall(glDeleteProgram(m_PendingProgram));
+        m_PendingProgram = 0;
+    }
+}
+
+ShaderProgramSource Shader::ParseShader(const std::string& filepath)
+{
+    m_Dependencies.clear();
 
-    std::string line;
     std::stringstream ss[2];
     ShaderType type = ShaderType::NONE;
+    if (!PreprocessFile(filepath, ss, type, 0))
+    {
+        return {};
+    }
+
+    return { InjectDefines(ss[0].str()), InjectDefines(ss[1].str()) };
+}
+
+bool Shader::PreprocessFile(const std::string& filepath, std::stringstream* stages, ShaderType& type, int depth)
+{
+    if (depth > MaxIncludeDepth)
+    {
+        std::cout << "Shader includes nested too deeply (cycle?) at " << filepath << std::endl;
+        return false;
+    }
+
+    std::ifstream stream(filepath);
+    if (!stream)
+    {
+        std::cout << "Failed to open shader source: " << filepath << std::endl;
+        return false;
+    }
+    if (std::find(m_Dependencies.begin(), m_Dependencies.end(), filepath) == m_Dependencies.end())
+    {
+        m_Dependencies.push_back(filepath);
+    }
+
+    std::string line;
     while (getline(stream, line))
     {
+        size_t directive = line.find_first_not_of(" \t");
         if (line.find("#shader") != std::string::npos)
         {
             if (line.find("vertex") != std::string::npos)
@@ -37,13 +289,48 @@ ShaderProgramSource Shader::ParseShader(const std::string& filepath)
                 type = ShaderType::FRAGMENT;
             }
         }
-        else 
+        else if (directive != std::string::npos && line.compare(directive, 8, "#include") == 0)
+        {
+            size_t open = line.find('"', directive);
+            size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+            if (close == std::string::npos)
+            {
+                std::cout << "Malformed #include in " << filepath << ": " << line << std::endl;
+                return false;
+            }
+
+            std::filesystem::path include = std::filesystem::path(filepath).parent_path() / line.substr(open + 1, close - open - 1);
+            if (!PreprocessFile(include.generic_string(), stages, type, depth + 1))
+            {
+                return false;
+            }
+        }
+        else if (type != ShaderType::NONE)
         {
-            ss[(int)type] << line << '\n';
+            stages[(int)type] << line << '\n';
         }
     }
+    return true;
+}
+
+std::string Shader::InjectDefines(const std::string& source) const
+{
+    if (m_Defines.empty())
+    {
+        return source;
+    }
 
-    return { ss[0].str(), ss[1].str() };
+    // #version must stay the first directive, so the defines go right after it
+    size_t version = source.find("#version");
+    size_t insert = version == std::string::npos ? 0 : source.find('\n', version);
+    insert = insert == std::string::npos ? source.size() : insert + 1;
+
+    std::string defines;
+    for (const std::string& define : m_Defines)
+    {
+        defines += "#define " + define + "\n";
+    }
+    return source.substr(0, insert) + defines + source.substr(insert);
 }
 
 unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
@@ -76,25 +363,138 @@ unsigned int Shader::CreateShader(const std::string& vertexShader, const std::st
     unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader);
     unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
 
+    // Left unlinked, which IsLinked() reports, rather than attaching a shader that doesn't exist
+    if (vs == 0 || fs == 0)
+    {
+        GLCall(glDeleteShader(vs));
+        GLCall(glDeleteShader(fs));
+        return program;
+    }
+
     GLCall(glAttachShader(program, vs));
     GLCall(glAttachShader(program, fs));
+    if (GLExtensions::ProgramBinary)
+    {
+        GLCall(GLExtensions::ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    }
     GLCall(glLinkProgram(program));
     GLCall(glValidateProgram(program));
 
+    int linked;
+    GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+    if (linked == GL_FALSE)
+    {
+        int length;
+        GLCall(glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length));
+        std::vector<char> message(length + 1, '\0');
+        GLCall(glGetProgramInfoLog(program, length, &length, message.data()));
+        std::cout << "Failed to link shader program " << m_Filepath << std::endl;
+        std::cout << message.data() << std::endl;
+    }
+
     GLCall(glDeleteShader(vs));
     GLCall(glDeleteShader(fs));
 
     return program;
 }
 
+std::string Shader::GetBinaryCachePath() const
+{
+    // One file per variant, e.g. basic.shader.PICKING.bin
+    std::string name = std::filesystem::path(m_Filepath).filename().string();
+    for (const std::string& define : m_Defines)
+    {
+        name += '.';
+        for (char c : define)
+        {
+            name += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+        }
+    }
+    return (std::filesystem::path(m_Filepath).parent_path() / "cache" / (name + ".bin")).string();
+}
+
+unsigned int Shader::LoadProgramBinary(const std::string& cachePath, uint64_t sourceHash, uint64_t driverHash)
+{
+    std::ifstream stream(cachePath, std::ios::binary);
+    if (!stream)
+    {
+        return 0;
+    }
+
+    BinaryCacheHeader header;
+    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || header.magic != BinaryCacheMagic || header.version != BinaryCacheVersion
+        || header.sourceHash != sourceHash || header.driverHash != driverHash)
+    {
+        return 0;
+    }
+
+    std::vector<char> binary(header.length);
+    if (!stream.read(binary.data(), binary.size()))
+    {
+        return 0;
+    }
+
+    GLCall(unsigned int program = glCreateProgram());
+
+    // Drivers may reject a binary (INVALID_ENUM for an unknown format, or a failed link after an
+    // update that kept the version string), which is not an error here: fall back to compiling
+    int linked = GL_FALSE;
+    GLExtensions::LoadProgramBinary(program, header.format, binary.data(), header.length);
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    GLClearError();
+    if (linked == GL_FALSE)
+    {
+        GLCall(glDeleteProgram(program));
+        return 0;
+    }
+    return program;
+}
+
+void Shader::SaveProgramBinary(unsigned int program, const std::string& cachePath, uint64_t sourceHash, uint64_t driverHash)
+{
+    int linked;
+    int length;
+    GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+    GLCall(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (linked == GL_FALSE || length <= 0)
+    {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLCall(GLExtensions::GetProgramBinary(program, length, &length, &format, binary.data()));
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), error);
+    std::ofstream stream(cachePath, std::ios::binary | std::ios::trunc);
+    if (!stream)
+    {
+        std::cout << "Failed to write shader cache: " << cachePath << std::endl;
+        return;
+    }
+
+    BinaryCacheHeader header = { BinaryCacheMagic, BinaryCacheVersion, sourceHash, driverHash, format, static_cast<uint32_t>(length) };
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(binary.data(), length);
+}
+
+bool Shader::IsLinked() const
+{
+    GLint linked = GL_FALSE;
+    GLCall(glGetProgramiv(m_RendererID, GL_LINK_STATUS, &linked));
+    return linked == GL_TRUE;
+}
+
 void Shader::Bind() const
 {
-    GLCall(glUseProgram(m_RendererID));
+    GLStateCache::UseProgram(m_RendererID);
 }
 
 void Shader::Unbind() const
 {
-    GLCall(glUseProgram(0));
+    GLStateCache::UseProgram(0);
 }
 
 void Shader::SetUniform1i(const std::string& name, int value)
@@ -102,6 +502,11 @@ void Shader::SetUniform1i(const std::string& name, int value)
     GLCall(glUniform1i(GetUniformLocation(name), value));
 }
 
+void Shader::SetUniform1ui(const std::string& name, unsigned int value)
+{
+    GLCall(glUniform1ui(GetUniformLocation(name), value));
+}
+
 void Shader::SetUniform1f(const std::string& name, float value)
 {
     GLCall(glUniform1f(GetUniformLocation(name), value));
@@ -122,6 +527,17 @@ void Shader::SetUniformMat4f(const std::string& name, const glm::mat4& matrix)
     GLCall(glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, &matrix[0][0]));
 }
 
+void Shader::SetUniformBlockBinding(const std::string& name, unsigned int binding)
+{
+    GLCall(unsigned int index = glGetUniformBlockIndex(m_RendererID, name.c_str()));
+    if (index == GL_INVALID_INDEX)
+    {
+        std::cout << "Warning: uniform block '" << name << "' doesn't exist!" << std::endl;
+        return;
+    }
+    GLCall(glUniformBlockBinding(m_RendererID, index, binding));
+}
+
 int Shader::GetUniformLocation(const std::string& name)
 {
     if (m_UniformLocationCache.find(name) != m_UniformLocationCache.end())
@@ -0,0 +1,314 @@
+#include <SolutionCache.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <utility>
+
+namespace
+{
+    const uint32_t CacheFileMagic = 0x43535243; // "CRSC"
+    const uint32_t CacheFileVersion = 1;
+}
+
+SolutionCache::SolutionCache(size_t capacityBytes, unsigned int shardCount)
+    : m_ShardCapacity(0), m_Hits(0), m_Misses(0)
+{
+    if (shardCount == 0)
+    {
+        shardCount = 1;
+    }
+    for (unsigned int i = 0; i < shardCount; ++i)
+    {
+        m_Shards.push_back(std::make_unique<Shard>());
+    }
+    m_ShardCapacity = capacityBytes / shardCount;
+}
+
+bool SolutionCache::Lookup(const CubeState& state, std::vector<CubeMove>& solution)
+{
+    int transform = 0;
+    uint64_t key = state.CanonicalHash(&transform);
+    int inverse = CubeState::InverseOrientation(transform);
+
+    Shard& shard = ShardFor(key);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end())
+        {
+            m_Misses++;
+            return false;
+        }
+
+        Entry& entry = shard.entries[it->second];
+        solution.clear();
+        solution.reserve(entry.moves.size());
+        CubeState check = state;
+        bool valid = true;
+        for (uint8_t packed : entry.moves)
+        {
+            if (!IsValidMove(packed))
+            {
+                valid = false;
+                break;
+            }
+            solution.push_back(CubeState::TransformMove(UnpackMove(packed), inverse));
+            check.ApplyMove(solution.back());
+        }
+
+        // The key is only a hash: a collision or a stale cache file must not hand out a wrong solution.
+        // Dropping the entry lets the solver's answer for this state take its place.
+        if (!valid || !check.IsSolved())
+        {
+            RemoveEntry(shard, it->second);
+            solution.clear();
+            m_Misses++;
+            return false;
+        }
+        entry.referenced = true;
+    }
+    m_Hits++;
+    return true;
+}
+
+void SolutionCache::Insert(const CubeState& state, const std::vector<CubeMove>& solution)
+{
+    int transform = 0;
+    uint64_t key = state.CanonicalHash(&transform);
+
+    std::vector<uint8_t> moves;
+    moves.reserve(solution.size());
+    for (const CubeMove& move : solution)
+    {
+        moves.push_back(PackMove(CubeState::TransformMove(move, transform)));
+    }
+    InsertCanonical(key, std::move(moves));
+}
+
+void SolutionCache::Clear()
+{
+    for (auto& shard : m_Shards)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->index.clear();
+        shard->entries.clear();
+        shard->freeSlots.clear();
+        shard->hand = 0;
+        shard->bytes = 0;
+    }
+}
+
+bool SolutionCache::Save(const std::string& filepath)
+{
+    std::ofstream stream(filepath, std::ios::binary | std::ios::trunc);
+    if (!stream)
+    {
+        std::cout << "Failed to open solution cache for writing: " << filepath << std::endl;
+        return false;
+    }
+
+    stream.write(reinterpret_cast<const char*>(&CacheFileMagic), sizeof(CacheFileMagic));
+    stream.write(reinterpret_cast<const char*>(&CacheFileVersion), sizeof(CacheFileVersion));
+    for (auto& shard : m_Shards)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const Entry& entry : shard->entries)
+        {
+            // The file stores 16-bit move counts; longer solutions are left out rather than truncated
+            if (!entry.used || entry.moves.size() > std::numeric_limits<uint16_t>::max())
+            {
+                continue;
+            }
+            uint16_t count = static_cast<uint16_t>(entry.moves.size());
+            stream.write(reinterpret_cast<const char*>(&entry.key), sizeof(entry.key));
+            stream.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            stream.write(reinterpret_cast<const char*>(entry.moves.data()), count);
+        }
+    }
+    return static_cast<bool>(stream);
+}
+
+bool SolutionCache::Load(const std::string& filepath)
+{
+    std::ifstream stream(filepath, std::ios::binary);
+    if (!stream)
+    {
+        return false;
+    }
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    stream.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    stream.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!stream || magic != CacheFileMagic || version != CacheFileVersion)
+    {
+        std::cout << "Ignoring incompatible solution cache: " << filepath << std::endl;
+        return false;
+    }
+
+    // Nothing is inserted until the whole file has been read and every move in it checked
+    std::vector<std::pair<uint64_t, std::vector<uint8_t>>> entries;
+    uint64_t key = 0;
+    uint16_t count = 0;
+    while (stream.read(reinterpret_cast<char*>(&key), sizeof(key))
+        && stream.read(reinterpret_cast<char*>(&count), sizeof(count)))
+    {
+        std::vector<uint8_t> moves(count);
+        if (!stream.read(reinterpret_cast<char*>(moves.data()), count)
+            || !std::all_of(moves.begin(), moves.end(), IsValidMove))
+        {
+            std::cout << "Ignoring corrupt solution cache: " << filepath << std::endl;
+            return false;
+        }
+        entries.emplace_back(key, std::move(moves));
+    }
+
+    for (auto& entry : entries)
+    {
+        InsertCanonical(entry.first, std::move(entry.second));
+    }
+    return true;
+}
+
+size_t SolutionCache::GetSizeBytes()
+{
+    size_t total = 0;
+    for (auto& shard : m_Shards)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->bytes;
+    }
+    return total;
+}
+
+SolutionCache::Shard& SolutionCache::ShardFor(uint64_t key)
+{
+    // Low bits pick the bucket inside unordered_map, so shard on the high bits
+    return *m_Shards[(key >> 48) % m_Shards.size()];
+}
+
+void SolutionCache::InsertCanonical(uint64_t key, std::vector<uint8_t> moves)
+{
+    size_t bytes = EntryBytes(moves.size());
+    if (bytes > m_ShardCapacity)
+    {
+        return;
+    }
+
+    Shard& shard = ShardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(key);
+    if (it != shard.index.end())
+    {
+        // Keep the shorter solution for a position
+        Entry& entry = shard.entries[it->second];
+        entry.referenced = true;
+        if (moves.size() < entry.moves.size())
+        {
+            shard.bytes -= EntryBytes(entry.moves.size()) - bytes;
+            entry.moves = std::move(moves);
+        }
+        return;
+    }
+
+    while (shard.bytes + bytes > m_ShardCapacity)
+    {
+        if (!EvictOne(shard))
+        {
+            return;
+        }
+    }
+
+    size_t slot = 0;
+    if (!shard.freeSlots.empty())
+    {
+        slot = shard.freeSlots.back();
+        shard.freeSlots.pop_back();
+    }
+    else
+    {
+        slot = shard.entries.size();
+        shard.entries.emplace_back();
+    }
+
+    Entry& entry = shard.entries[slot];
+    entry.key = key;
+    entry.moves = std::move(moves);
+    entry.referenced = false;
+    entry.used = true;
+    shard.index[key] = slot;
+    shard.bytes += bytes;
+}
+
+bool SolutionCache::EvictOne(Shard& shard)
+{
+    if (shard.index.empty())
+    {
+        return false;
+    }
+
+    // CLOCK: give referenced entries a second chance, evict the first unreferenced one
+    while (true)
+    {
+        if (shard.hand >= shard.entries.size())
+        {
+            shard.hand = 0;
+        }
+        Entry& entry = shard.entries[shard.hand];
+        size_t slot = shard.hand++;
+        if (!entry.used)
+        {
+            continue;
+        }
+        if (entry.referenced)
+        {
+            entry.referenced = false;
+            continue;
+        }
+
+        RemoveEntry(shard, slot);
+        return true;
+    }
+}
+
+void SolutionCache::RemoveEntry(Shard& shard, size_t slot)
+{
+    Entry& entry = shard.entries[slot];
+    shard.bytes -= EntryBytes(entry.moves.size());
+    shard.index.erase(entry.key);
+    entry.used = false;
+    entry.moves.clear();
+    entry.moves.shrink_to_fit();
+    shard.freeSlots.push_back(slot);
+}
+
+size_t SolutionCache::EntryBytes(size_t moveCount)
+{
+    // Entry, its index node (key, slot, bucket links) and the packed moves
+    return sizeof(Entry) + sizeof(uint64_t) + sizeof(size_t) + 2 * sizeof(void*) + moveCount;
+}
+
+uint8_t SolutionCache::PackMove(const CubeMove& move)
+{
+    int turns = ((move.turns % 4) + 4) % 4;
+    return static_cast<uint8_t>(move.axis | ((move.layer + 1) << 2) | (turns << 4));
+}
+
+bool SolutionCache::IsValidMove(uint8_t packed)
+{
+    // Axis below 3, layer -1..1 stored as 0..2, a non-zero quarter-turn count and no stray high bits
+    return (packed & 3) < 3 && ((packed >> 2) & 3) <= 2 && ((packed >> 4) & 3) != 0 && (packed >> 6) == 0;
+}
+
+CubeMove SolutionCache::UnpackMove(uint8_t packed)
+{
+    CubeMove move;
+    move.axis = packed & 3;
+    move.layer = ((packed >> 2) & 3) - 1;
+    int turns = (packed >> 4) & 3;
+    move.turns = turns == 3 ? -1 : turns;
+    return move;
+}
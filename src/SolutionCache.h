@@ -0,0 +1,69 @@
+#pragma once
+
+#include <CubeState.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Thread-safe cache from canonical cube state to solution, bounded by bytes.
+// Keys are CubeState::CanonicalHash, so symmetric and recolored positions share one entry;
+// solutions are stored in the canonical frame and mapped back to the caller's frame on lookup,
+// where they are replayed on a copy of the state and only returned if they actually solve it.
+// Each shard has its own lock and CLOCK eviction hand.
+class SolutionCache
+{
+    private:
+        struct Entry
+        {
+            uint64_t key = 0;
+            std::vector<uint8_t> moves;
+            bool referenced = false;
+            bool used = false;
+        };
+
+        struct Shard
+        {
+            std::mutex mutex;
+            std::unordered_map<uint64_t, size_t> index;
+            std::vector<Entry> entries;
+            std::vector<size_t> freeSlots;
+            size_t hand = 0;
+            size_t bytes = 0;
+        };
+
+        std::vector<std::unique_ptr<Shard>> m_Shards;
+        size_t m_ShardCapacity;
+        std::atomic<uint64_t> m_Hits;
+        std::atomic<uint64_t> m_Misses;
+    public:
+        SolutionCache(size_t capacityBytes = 16 * 1024 * 1024, unsigned int shardCount = 16);
+
+        bool Lookup(const CubeState& state, std::vector<CubeMove>& solution);
+        void Insert(const CubeState& state, const std::vector<CubeMove>& solution);
+        void Clear();
+
+        // Binary persistence, entries are reinserted through the normal byte budget on load
+        bool Save(const std::string& filepath);
+        bool Load(const std::string& filepath);
+
+        size_t GetSizeBytes();
+        inline uint64_t GetHitCount() const { return m_Hits.load(); }
+        inline uint64_t GetMissCount() const { return m_Misses.load(); }
+    private:
+        Shard& ShardFor(uint64_t key);
+        void InsertCanonical(uint64_t key, std::vector<uint8_t> moves);
+        bool EvictOne(Shard& shard);
+        void RemoveEntry(Shard& shard, size_t slot);
+
+        static size_t EntryBytes(size_t moveCount);
+        static uint8_t PackMove(const CubeMove& move);
+        // False for bytes PackMove never produces, which a corrupt file could still hold
+        static bool IsValidMove(uint8_t packed);
+        static CubeMove UnpackMove(uint8_t packed);
+};
@@ -0,0 +1,85 @@
+#include <StickerAtlas.h>
+
+#include <CubieMesh.h>
+
+#include <algorithm>
+#include <cmath>
+
+StickerAtlas::StickerAtlas(int puzzleCount)
+    : m_Texture(ColumnsFor(puzzleCount) * TileWidth,
+        ((std::max(puzzleCount, 1) + ColumnsFor(puzzleCount) - 1) / ColumnsFor(puzzleCount)) * TileHeight),
+      m_Columns(ColumnsFor(puzzleCount)), m_Tiles(std::max(puzzleCount, 1)),
+      m_Pixels(TileWidth * TileHeight * 4), m_BakeCount(0)
+{
+    // Where each facelet lands in its face image depends only on the mesh's texture coordinates
+    for (int face = 0; face < 6; ++face)
+    {
+        int axis = face / 2;
+        int first = axis == 0 ? 1 : 0;
+        int second = axis == 2 ? 1 : 2;
+        for (int a = 0; a < 3; ++a)
+        {
+            for (int b = 0; b < 3; ++b)
+            {
+                glm::vec3 center(0.0f);
+                center[axis] = face % 2 == 0 ? 0.5f : -0.5f;
+                center[first] = static_cast<float>(a - 1) / 3.0f;
+                center[second] = static_cast<float>(b - 1) / 3.0f;
+                glm::vec2 texCoord = CubieMesh::GetFaceTexCoord(face, center);
+                int column = std::clamp(static_cast<int>(texCoord.x * 3.0f), 0, 2);
+                int row = std::clamp(static_cast<int>(texCoord.y * 3.0f), 0, 2);
+                m_FaceletCell[face * 9 + 3 * a + b] = static_cast<uint8_t>(row * 3 + column);
+            }
+        }
+    }
+}
+
+void StickerAtlas::Update(int puzzle, const RubiksCube::Snapshot& snapshot)
+{
+    Tile& tile = m_Tiles[puzzle];
+    if (tile.baked && tile.stateHash == snapshot.stateHash)
+    {
+        return;
+    }
+
+    const auto& palette = RubiksCube::GetPalette();
+    // Opaque black between the stickers
+    for (size_t i = 0; i < m_Pixels.size(); ++i)
+    {
+        m_Pixels[i] = i % 4 == 3 ? 255 : 0;
+    }
+    for (int facelet = 0; facelet < RubiksCube::FaceletCount; ++facelet)
+    {
+        const glm::vec4& color = palette[snapshot.facelets[facelet]];
+        unsigned char rgba[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            rgba[c] = static_cast<unsigned char>(std::lround(glm::clamp(color[c], 0.0f, 1.0f) * 255.0f));
+        }
+
+        // Fill the sticker, leaving its outermost texels black like the border of the sticker texture
+        int cell = m_FaceletCell[facelet];
+        int x0 = (facelet / 9) * FaceTexels + (cell % 3) * StickerTexels;
+        int y0 = (cell / 3) * StickerTexels;
+        for (int y = y0 + 1; y < y0 + StickerTexels - 1; ++y)
+        {
+            for (int x = x0 + 1; x < x0 + StickerTexels - 1; ++x)
+            {
+                std::copy(rgba, rgba + 4, m_Pixels.begin() + (y * TileWidth + x) * 4);
+            }
+        }
+    }
+
+    m_Texture.SetData((puzzle % m_Columns) * TileWidth, (puzzle / m_Columns) * TileHeight, TileWidth, TileHeight, m_Pixels.data());
+    tile.baked = true;
+    tile.stateHash = snapshot.stateHash;
+    m_BakeCount++;
+}
+
+int StickerAtlas::ColumnsFor(int puzzleCount)
+{
+    // Roughly square, tiles are six times wider than tall
+    float tiles = static_cast<float>(std::max(puzzleCount, 1));
+    int columns = static_cast<int>(std::ceil(std::sqrt(tiles * TileHeight / TileWidth)));
+    return std::clamp(columns, 1, std::max(puzzleCount, 1));
+}
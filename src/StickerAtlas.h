@@ -0,0 +1,48 @@
+#pragma once
+
+#include <RubiksCube.h>
+#include <Texture.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Sticker images of every puzzle in one shared texture, for drawing distant puzzles as a single box.
+// Each puzzle owns a tile holding its six faces side by side, in the face order and texture
+// orientation of CubieMesh, and the tile is only re-baked when the puzzle's state hash changes.
+// The LOD variant of basic.shader finds a tile from the instance's tile index and the texture size,
+// so the tile layout below must match it.
+class StickerAtlas
+{
+    public:
+        static const int StickerTexels = 8;  // One black texel on each side of the color
+        static const int FaceTexels = 3 * StickerTexels;
+        static const int TileWidth = 6 * FaceTexels;
+        static const int TileHeight = FaceTexels;
+    private:
+        struct Tile
+        {
+            bool baked = false;
+            uint64_t stateHash = 0;
+        };
+
+        Texture m_Texture;
+        int m_Columns;
+        std::vector<Tile> m_Tiles;
+        std::vector<unsigned char> m_Pixels;  // One tile, reused for every bake
+        std::array<uint8_t, RubiksCube::FaceletCount> m_FaceletCell;  // Facelet -> row * 3 + column in its face image
+        uint64_t m_BakeCount;
+    public:
+        StickerAtlas(int puzzleCount);
+
+        StickerAtlas(const StickerAtlas&) = delete;
+        StickerAtlas& operator=(const StickerAtlas&) = delete;
+
+        // Brings the puzzle's tile up to date with its snapshot; call on the GL thread before drawing it
+        void Update(int puzzle, const RubiksCube::Snapshot& snapshot);
+
+        inline const Texture& GetTexture() const { return m_Texture; }
+        inline uint64_t GetBakeCount() const { return m_BakeCount; }
+    private:
+        static int ColumnsFor(int puzzleCount);
+};
@@ -0,0 +1,151 @@
+#include <StreamBuffer.h>
+#include <GLExtensions.h>
+#include <GLStateCache.h>
+
+#include <algorithm>
+
+namespace
+{
+    // Keeps every range suitably aligned for any vertex attribute type
+    const size_t RangeAlignment = 64;
+}
+
+StreamBuffer::StreamBuffer(unsigned int target, size_t capacity)
+    : m_RendererID(0), m_Target(target), m_Capacity(0), m_Persistent(false), m_Mapped(nullptr),
+      m_Head(0), m_RangeBegin(0), m_RangeEnd(0)
+{
+    Allocate(capacity);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    Release();
+}
+
+void* StreamBuffer::Map(size_t size)
+{
+    if (size > m_Capacity)
+    {
+        // Rare: size the ring for a few ranges of the new size so steady state never grows again
+        Release();
+        Allocate(std::max(m_Capacity * 2, size * 3));
+    }
+
+    if (!m_Persistent)
+    {
+        Bind();
+        GLCall(glBufferData(m_Target, m_Capacity, nullptr, GL_STREAM_DRAW));
+        GLCall(m_Mapped = static_cast<unsigned char*>(glMapBufferRange(m_Target, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT)));
+        m_RangeBegin = 0;
+        m_RangeEnd = size;
+        return m_Mapped;
+    }
+
+    size_t begin = (m_Head + RangeAlignment - 1) / RangeAlignment * RangeAlignment;
+    if (begin + size > m_Capacity)
+    {
+        begin = 0;
+    }
+    size_t end = begin + size;
+
+    // Fences signal in the order they were inserted, so waiting up to the newest overlapping range
+    // costs nothing over waiting for that range alone and keeps the queue ordered
+    size_t retire = 0;
+    for (size_t i = 0; i < m_Pending.size(); ++i)
+    {
+        if (m_Pending[i].begin < end && m_Pending[i].end > begin)
+        {
+            retire = i + 1;
+        }
+    }
+    for (size_t i = 0; i < retire; ++i)
+    {
+        WaitFor(m_Pending.front());
+        m_Pending.pop_front();
+    }
+
+    m_RangeBegin = begin;
+    m_RangeEnd = end;
+    m_Head = end;
+    return m_Mapped + begin;
+}
+
+void StreamBuffer::Unmap()
+{
+    // Persistent storage is coherent, the writes need no flush
+    if (!m_Persistent)
+    {
+        Bind();
+        GLCall(glUnmapBuffer(m_Target));
+        m_Mapped = nullptr;
+    }
+}
+
+void StreamBuffer::Fence()
+{
+    if (m_Persistent && m_RangeEnd > m_RangeBegin)
+    {
+        GLCall(GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        m_Pending.push_back({ m_RangeBegin, m_RangeEnd, fence });
+    }
+}
+
+void StreamBuffer::Bind() const
+{
+    GLStateCache::BindBuffer(m_Target, m_RendererID);
+}
+
+void StreamBuffer::Allocate(size_t capacity)
+{
+    m_Capacity = capacity;
+    m_Persistent = GLExtensions::BufferStorage;
+    m_Head = 0;
+
+    GLCall(glGenBuffers(1, &m_RendererID));
+    Bind();
+    if (m_Persistent)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLCall(GLExtensions::AllocateBufferStorage(m_Target, m_Capacity, nullptr, flags));
+        GLCall(m_Mapped = static_cast<unsigned char*>(glMapBufferRange(m_Target, 0, m_Capacity, flags)));
+    }
+    else
+    {
+        GLCall(glBufferData(m_Target, m_Capacity, nullptr, GL_STREAM_DRAW));
+    }
+}
+
+void StreamBuffer::Release()
+{
+    // Deleting the buffer is enough for pending draws, GL keeps the storage alive until they are done
+    for (const PendingRange& range : m_Pending)
+    {
+        GLCall(glDeleteSync(range.fence));
+    }
+    m_Pending.clear();
+
+    if (m_Mapped)
+    {
+        Bind();
+        GLCall(glUnmapBuffer(m_Target));
+        m_Mapped = nullptr;
+    }
+    GLStateCache::ForgetBuffer(m_RendererID);
+    GLCall(glDeleteBuffers(1, &m_RendererID));
+    m_RendererID = 0;
+}
+
+void StreamBuffer::WaitFor(const PendingRange& range)
+{
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (true)
+    {
+        GLCall(GLenum result = glClientWaitSync(range.fence, flags, 1000000));
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+        {
+            break;
+        }
+        flags = 0;
+    }
+    GLCall(glDeleteSync(range.fence));
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Debugger.h>
+
+#include <cstddef>
+#include <deque>
+
+// Ring buffer for data rewritten every frame (e.g. per-instance transforms).
+// With ARB_buffer_storage the storage is allocated once and stays persistently mapped; each Map()
+// hands out the next free range and only waits on the fence of a range the GPU may still read.
+// Without it, every Map() orphans the buffer so the driver never synchronizes with pending draws.
+class StreamBuffer
+{
+    private:
+        struct PendingRange
+        {
+            size_t begin;
+            size_t end;
+            GLsync fence;
+        };
+
+        unsigned int m_RendererID;
+        unsigned int m_Target;
+        size_t m_Capacity;
+        bool m_Persistent;
+        unsigned char* m_Mapped;  // Whole buffer when persistent, the current range otherwise
+
+        size_t m_Head;
+        size_t m_RangeBegin;
+        size_t m_RangeEnd;
+        std::deque<PendingRange> m_Pending;
+    public:
+        StreamBuffer(unsigned int target, size_t capacity);
+        ~StreamBuffer();
+
+        StreamBuffer(const StreamBuffer&) = delete;
+        StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+        // Returns 'size' writable bytes; the storage grows if they don't fit
+        void* Map(size_t size);
+        void Unmap();
+        // Call after the draws reading the last mapped range were issued
+        void Fence();
+
+        void Bind() const;
+
+        // Byte offset of the last mapped range inside the buffer
+        inline size_t GetOffset() const { return m_RangeBegin; }
+        inline bool IsPersistent() const { return m_Persistent; }
+    private:
+        void Allocate(size_t capacity);
+        void Release();
+        void WaitFor(const PendingRange& range);
+};
@@ -1,59 +1,255 @@
-#include <stb/stb_image.h>
-#include <stb/stb_image_write.h>
-
 #include <Texture.h>
+#include <AssetLoader.h>
+#include <GLStateCache.h>
+
+#include <algorithm>
 
-Texture::Texture(const std::string& filepath)
-    : m_RendererID(0), m_Filepath(filepath), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_Components(0)
+Texture::Texture(const std::string& filepath, int channels)
+    : m_RendererID(0), m_Target(GL_TEXTURE_2D), m_Filepath(filepath), m_Width(0), m_Height(0), m_Layers(1), m_Loader(nullptr)
 {
-    // Flips the image so it appears right side up
-    stbi_set_flip_vertically_on_load(1);
+    Load({ filepath }, channels);
+}
 
-    // Reads the image from a file and stores it in m_LocalBuffer
-    m_LocalBuffer = stbi_load(filepath.c_str(), &m_Width, &m_Height, &m_Components, 4);
+Texture::Texture(const std::vector<std::string>& filepaths, int channels)
+    : m_RendererID(0), m_Target(GL_TEXTURE_2D_ARRAY), m_Filepath(filepaths.empty() ? "" : filepaths.front()), m_Width(0), m_Height(0), m_Layers(0), m_Loader(nullptr)
+{
+    Load(filepaths, channels);
+}
 
-    // Generates an OpenGL texture object
+Texture::Texture(const std::vector<std::string>& filepaths, AssetLoader& loader, int channels)
+    : m_RendererID(0), m_Target(GL_TEXTURE_2D_ARRAY), m_Filepath(filepaths.empty() ? "" : filepaths.front()), m_Width(0), m_Height(0), m_Layers(0), m_Loader(&loader)
+{
+    CreatePlaceholder();
+    loader.Load(*this, filepaths, channels);
+}
+
+Texture::Texture(int width, int height)
+    : m_RendererID(0), m_Target(GL_TEXTURE_2D), m_Width(width), m_Height(height), m_Layers(1), m_Loader(nullptr)
+{
     GLCall(glGenTextures(1, &m_RendererID));
+    GLStateCache::BindTexture(0, GL_TEXTURE_2D, m_RendererID);
 
-    // Assigns the texture to a Texture Unit
-    GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+    // Filled and updated piecewise, so there are no mipmaps to keep in sync
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
 
-    // Configures the type of algorithm that is used to make the image smaller or bigger
-    GLCall(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR));
-    GLCall(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
 
-    // Configures the way the texture repeats (if it does at all)
-    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
+    GLStateCache::BindTexture(0, GL_TEXTURE_2D, 0);
+}
 
-    // Assigns the image to the OpenGL Texture object
-    GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_LocalBuffer));
+Texture::~Texture()
+{
+    if (m_Loader)
+    {
+        m_Loader->Cancel(*this);
+    }
+    GLStateCache::ForgetTexture(m_RendererID);
+    GLCall(glDeleteTextures(1, &m_RendererID));
+}
 
-    // Generates Mipmaps
-	GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+void Texture::SetData(int x, int y, int width, int height, const void* pixels)
+{
+    GLStateCache::BindTexture(0, GL_TEXTURE_2D, m_RendererID);
+    GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+}
+
+void Texture::Bind(unsigned int slot) const
+{
+    GLStateCache::BindTexture(slot, m_Target, m_RendererID);
+}
+
+void Texture::Unbind(unsigned int slot) const
+{
+    GLStateCache::BindTexture(slot, m_Target, 0);
+}
+
+void Texture::Load(const std::vector<std::string>& filepaths, int channels)
+{
+    std::vector<TextureImage> images(filepaths.size());
+    for (size_t i = 0; i < filepaths.size(); ++i)
+    {
+        TextureImage::Load(filepaths[i], images[i], channels);
+    }
+    MatchLayers(filepaths, images);
+
+    const TextureImage& first = images.front();
+    unsigned int texture = Allocate(m_Target, first, static_cast<int>(images.size()));
+    for (size_t layer = 0; layer < images.size(); ++layer)
+    {
+        for (size_t level = 0; level < first.levels.size(); ++level)
+        {
+            const TextureImage::Level& mip = images[layer].levels[level];
+            int rows = (mip.height + first.GetRowHeight() - 1) / first.GetRowHeight();
+            UploadRows(m_Target, images[layer], static_cast<int>(level), static_cast<int>(layer), 0, rows, mip.data.data());
+        }
+    }
+    FinishMipmaps(m_Target, first);
 
     // Unbinds the OpenGL Texture object so that it can't accidentally be modified
-    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+    GLStateCache::BindTexture(0, m_Target, 0);
+    Adopt(texture, first, static_cast<int>(images.size()));
+}
+
+void Texture::CreatePlaceholder()
+{
+    std::vector<TextureImage> images;
+    MatchLayers({}, images);
+    unsigned int texture = Allocate(m_Target, images.front(), 1);
+    UploadRows(m_Target, images.front(), 0, 0, 0, 1, images.front().levels[0].data.data());
+    FinishMipmaps(m_Target, images.front());
+    GLStateCache::BindTexture(0, m_Target, 0);
+    Adopt(texture, images.front(), 1);
+}
+
+void Texture::Adopt(unsigned int texture, const TextureImage& first, int layers)
+{
+    if (m_RendererID != 0)
+    {
+        GLStateCache::ForgetTexture(m_RendererID);
+        GLCall(glDeleteTextures(1, &m_RendererID));
+    }
+    m_RendererID = texture;
+    m_Width = first.levels[0].width;
+    m_Height = first.levels[0].height;
+    m_Layers = m_Target == GL_TEXTURE_2D_ARRAY ? layers : 1;
+}
 
-    if (m_LocalBuffer)
+void Texture::MatchLayers(const std::vector<std::string>& filepaths, std::vector<TextureImage>& images)
+{
+    // Layers share one allocation, so each has to match the first image that loaded
+    std::vector<TextureImage> layers;
+    for (size_t i = 0; i < images.size(); ++i)
     {
-        // Deletes the image data as it is already in the OpenGL Texture object
-        stbi_image_free(m_LocalBuffer);
+        TextureImage& image = images[i];
+        if (image.levels.empty())
+        {
+            continue;
+        }
+        if (!layers.empty())
+        {
+            const TextureImage& first = layers.front();
+            if (image.internalFormat != first.internalFormat || image.levels.size() != first.levels.size()
+                || image.levels[0].width != first.levels[0].width || image.levels[0].height != first.levels[0].height)
+            {
+                std::cout << "Skipping texture layer " << filepaths[i] << ": size, format or mipmaps differ from the first layer" << std::endl;
+                continue;
+            }
+        }
+        layers.push_back(std::move(image));
     }
+
+    // Nothing usable: one white texel, which leaves the stickers their plain palette color
+    if (layers.empty())
+    {
+        TextureImage white;
+        white.internalFormat = GL_RGBA8;
+        white.format = GL_RGBA;
+        white.type = GL_UNSIGNED_BYTE;
+        white.levels.resize(1);
+        white.levels[0].width = 1;
+        white.levels[0].height = 1;
+        white.levels[0].data.assign(4, 255);
+        layers.push_back(std::move(white));
+    }
+    images = std::move(layers);
 }
 
-Texture::~Texture()
+unsigned int Texture::Allocate(unsigned int target, const TextureImage& first, int layers)
 {
-    GLCall(glDeleteTextures(1, &m_RendererID));
+    // Generates an OpenGL texture object
+    unsigned int texture = 0;
+    GLCall(glGenTextures(1, &texture));
+
+    // Assigns the texture to a Texture Unit
+    GLStateCache::BindTexture(0, target, texture);
+
+    // Configures the type of algorithm that is used to make the image smaller or bigger
+    GLCall(glTexParameterf(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR));
+    GLCall(glTexParameterf(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+
+    // Configures the way the texture repeats (if it does at all)
+    GLCall(glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT));
+    GLCall(glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT));
+
+    // Grey masks keep a quarter of the memory, but still read as grey (with alpha) in every channel
+    if (first.format == GL_RED || first.format == GL_RG || first.internalFormat == GL_COMPRESSED_RED_RGTC1)
+    {
+        GLint alpha = first.format == GL_RG ? GL_GREEN : GL_ONE;
+        GLint swizzle[4] = { GL_RED, GL_RED, GL_RED, alpha };
+        GLCall(glTexParameteriv(target, GL_TEXTURE_SWIZZLE_RGBA, swizzle));
+    }
+
+    // Storage for every level of every layer, filled in afterwards
+    for (size_t level = 0; level < first.levels.size(); ++level)
+    {
+        int width = first.levels[level].width;
+        int height = first.levels[level].height;
+        GLsizei size = static_cast<GLsizei>(first.levels[level].data.size());
+        if (target == GL_TEXTURE_2D && first.compressed)
+        {
+            GLCall(glCompressedTexImage2D(target, static_cast<int>(level), first.internalFormat, width, height, 0, size, nullptr));
+        }
+        else if (target == GL_TEXTURE_2D)
+        {
+            GLCall(glTexImage2D(target, static_cast<int>(level), first.internalFormat, width, height, 0, first.format, first.type, nullptr));
+        }
+        else if (first.compressed)
+        {
+            GLCall(glCompressedTexImage3D(target, static_cast<int>(level), first.internalFormat, width, height, layers, 0, size * layers, nullptr));
+        }
+        else
+        {
+            GLCall(glTexImage3D(target, static_cast<int>(level), first.internalFormat, width, height, layers, 0, first.format, first.type, nullptr));
+        }
+    }
+    return texture;
 }
 
-void Texture::Bind(unsigned int slot) const
+void Texture::UploadRows(unsigned int target, const TextureImage& image, int level, int layer, int firstRow, int rowCount, const void* pixels)
 {
-    GLCall(glActiveTexture(GL_TEXTURE0 + slot));
-    GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+    // Rows are block rows for compressed images; the last one may be cut off by the level's edge
+    const TextureImage::Level& mip = image.levels[level];
+    int y = firstRow * image.GetRowHeight();
+    int height = std::min(rowCount * image.GetRowHeight(), mip.height - y);
+    GLsizei size = static_cast<GLsizei>(image.GetRowBytes(level) * rowCount);
+    if (image.unpackAlignment != 4)
+    {
+        GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, image.unpackAlignment));
+    }
+    if (target == GL_TEXTURE_2D && image.compressed)
+    {
+        GLCall(glCompressedTexSubImage2D(target, level, 0, y, mip.width, height, image.internalFormat, size, pixels));
+    }
+    else if (target == GL_TEXTURE_2D)
+    {
+        GLCall(glTexSubImage2D(target, level, 0, y, mip.width, height, image.format, image.type, pixels));
+    }
+    else if (image.compressed)
+    {
+        GLCall(glCompressedTexSubImage3D(target, level, 0, y, layer, mip.width, height, 1, image.internalFormat, size, pixels));
+    }
+    else
+    {
+        GLCall(glTexSubImage3D(target, level, 0, y, layer, mip.width, height, 1, image.format, image.type, pixels));
+    }
+    if (image.unpackAlignment != 4)
+    {
+        GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+    }
 }
 
-void Texture::Unbind() const
+void Texture::FinishMipmaps(unsigned int target, const TextureImage& first)
 {
-    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
-}
\ No newline at end of file
+    // Generates Mipmaps, unless the file brought its own (compressed images can't be filtered down by GL)
+    if (first.levels.size() == 1 && !first.compressed)
+    {
+        GLCall(glGenerateMipmap(target));
+    }
+    else
+    {
+        GLCall(glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, static_cast<int>(first.levels.size()) - 1));
+    }
+}
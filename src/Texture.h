@@ -1,24 +1,68 @@
 #pragma once
 
 #include <Debugger.h>
+#include <TextureImage.h>
 
 #include <iostream>
 #include <string>
+#include <vector>
+
+class AssetLoader;
 
 class Texture
 {
     private:
         unsigned int m_RendererID;
+        unsigned int m_Target;
         std::string m_Filepath;
-        unsigned char* m_LocalBuffer;
-        int m_Width, m_Height, m_Components;
+        int m_Width, m_Height, m_Layers;
+        AssetLoader* m_Loader;  // Still streaming the files in when set
     public:
-        Texture(const std::string& filepath);
+        // Any format TextureImage reads; compressed files keep their own mipmaps.
+        // 'channels' is how many components PNG/JPG/... images keep: 1 is R8, 2 RG8, 3 RGB8 and 4 RGBA8.
+        // One and two channels are swizzled to read as grey (and alpha), like stb_image's own expansion.
+        Texture(const std::string& filepath, int channels = 4);
+        // GL_TEXTURE_2D_ARRAY with one layer per file, so draws can pick an image without rebinding.
+        // Every file must match the first in size, format and mip count; others are reported and skipped.
+        Texture(const std::vector<std::string>& filepaths, int channels = 4);
+        // Same array, but decoded and uploaded in the background by 'loader'; until it is done
+        // this is a single white layer, which draws the stickers in their plain palette color
+        Texture(const std::vector<std::string>& filepaths, AssetLoader& loader, int channels = 4);
+        // Empty RGBA8 texture without mipmaps, filled later with SetData
+        Texture(int width, int height);
         ~Texture();
 
+        Texture(const Texture&) = delete;
+        Texture& operator=(const Texture&) = delete;
+
+        // Replaces a rectangle of RGBA8 texels; row 0 is the bottom of the image
+        void SetData(int x, int y, int width, int height, const void* pixels);
+
         void Bind(unsigned int slot = 0) const;
-        void Unbind() const;
+        void Unbind(unsigned int slot = 0) const;
 
         inline int GetWidth() const { return m_Width; }
         inline int GetHeight() const { return m_Height; }
-};
\ No newline at end of file
+        inline int GetLayerCount() const { return m_Layers; }
+        inline unsigned int GetTarget() const { return m_Target; }
+        inline unsigned int GetRendererID() const { return m_RendererID; }
+        inline bool IsLoading() const { return m_Loader != nullptr; }
+    private:
+        friend class AssetLoader;
+
+        void Load(const std::vector<std::string>& filepaths, int channels);
+        void CreatePlaceholder();
+        // Takes ownership of 'texture', deleting the one this held
+        void Adopt(unsigned int texture, const TextureImage& first, int layers);
+
+        // Steps of Load, shared with AssetLoader which spreads them over several frames.
+        // Drops images that failed or don't match the first one; leaves a white texel if none is left.
+        static void MatchLayers(const std::vector<std::string>& filepaths, std::vector<TextureImage>& images);
+        // Generates a texture with storage for every level of 'layers' images like 'first', left bound to unit 0.
+        // Formats with fewer than three channels get a swizzle, so shaders read them like RGBA.
+        static unsigned int Allocate(unsigned int target, const TextureImage& first, int layers);
+        // Uploads whole rows of one level of one layer to the texture bound to unit 0; 'pixels' is an
+        // offset into the bound GL_PIXEL_UNPACK_BUFFER if there is one. Honors the image's row alignment.
+        static void UploadRows(unsigned int target, const TextureImage& image, int level, int layer, int firstRow, int rowCount, const void* pixels);
+        static void FinishMipmaps(unsigned int target, const TextureImage& first);
+};
@@ -0,0 +1,312 @@
+#include <TextureImage.h>
+
+#include <GLExtensions.h>
+
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace
+{
+    const uint32_t DdsMagic = 0x20534444;  // "DDS "
+    const size_t DdsHeaderSize = 4 + 124;
+    const size_t DdsDx10HeaderSize = 20;
+    const uint32_t DxgiFormatBC1 = 71;
+    const uint32_t DxgiFormatBC4 = 80;
+
+    const unsigned char KtxIdentifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+    const size_t KtxHeaderSize = 64;
+    const uint32_t KtxEndianness = 0x04030201;
+
+    uint32_t FourCC(const char* code)
+    {
+        return static_cast<uint32_t>(code[0]) | (static_cast<uint32_t>(code[1]) << 8)
+            | (static_cast<uint32_t>(code[2]) << 16) | (static_cast<uint32_t>(code[3]) << 24);
+    }
+
+    // Both containers are little-endian, like every platform this builds for
+    uint32_t ReadU32(const std::vector<unsigned char>& file, size_t offset)
+    {
+        uint32_t value = 0;
+        if (offset + sizeof(value) <= file.size())
+        {
+            std::memcpy(&value, file.data() + offset, sizeof(value));
+        }
+        return value;
+    }
+
+    bool HasExtension(const std::string& filepath, const std::string& extension)
+    {
+        if (filepath.size() < extension.size())
+        {
+            return false;
+        }
+        return std::equal(extension.rbegin(), extension.rend(), filepath.rbegin(),
+            [](char a, char b) { return a == std::tolower(static_cast<unsigned char>(b)); });
+    }
+
+    bool IsSupportedCompressedFormat(unsigned int internalFormat)
+    {
+        switch (internalFormat)
+        {
+            case GL_COMPRESSED_RED_RGTC1:
+                return true;
+            case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+            case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+                return GLExtensions::TextureCompressionS3TC;
+            default:
+                return false;
+        }
+    }
+
+    // BC1 and BC4 both store each 4x4 block of texels in 8 bytes
+    size_t CompressedLevelSize(int width, int height)
+    {
+        return static_cast<size_t>((width + 3) / 4) * static_cast<size_t>((height + 3) / 4) * 8;
+    }
+
+    // Cuts 'levelCount' tightly packed compressed levels out of 'file', starting at 'offset'
+    bool ReadCompressedLevels(const std::vector<unsigned char>& file, size_t offset, int width, int height, int levelCount, TextureImage& image)
+    {
+        for (int level = 0; level < levelCount; ++level)
+        {
+            size_t size = CompressedLevelSize(width, height);
+            if (offset + size > file.size())
+            {
+                return false;
+            }
+            TextureImage::Level mip;
+            mip.width = width;
+            mip.height = height;
+            mip.data.assign(file.begin() + offset, file.begin() + offset + size);
+            image.levels.push_back(std::move(mip));
+            offset += size;
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+        }
+        return true;
+    }
+
+    bool LoadDds(const std::vector<unsigned char>& file, TextureImage& image, std::string& error)
+    {
+        if (file.size() < DdsHeaderSize || ReadU32(file, 0) != DdsMagic)
+        {
+            error = "not a DDS file";
+            return false;
+        }
+        int height = static_cast<int>(ReadU32(file, 12));
+        int width = static_cast<int>(ReadU32(file, 16));
+        int levelCount = std::max(static_cast<int>(ReadU32(file, 28)), 1);
+        uint32_t fourCC = ReadU32(file, 84);
+
+        size_t offset = DdsHeaderSize;
+        if (fourCC == FourCC("DXT1"))
+        {
+            image.internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        }
+        else if (fourCC == FourCC("ATI1") || fourCC == FourCC("BC4U"))
+        {
+            image.internalFormat = GL_COMPRESSED_RED_RGTC1;
+        }
+        else if (fourCC == FourCC("DX10"))
+        {
+            uint32_t dxgiFormat = ReadU32(file, DdsHeaderSize);
+            uint32_t arraySize = ReadU32(file, DdsHeaderSize + 12);
+            if (arraySize > 1)
+            {
+                error = "DDS arrays are not supported, give one file per layer";
+                return false;
+            }
+            if (dxgiFormat == DxgiFormatBC1)
+            {
+                image.internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            }
+            else if (dxgiFormat == DxgiFormatBC4)
+            {
+                image.internalFormat = GL_COMPRESSED_RED_RGTC1;
+            }
+            offset += DdsDx10HeaderSize;
+        }
+
+        if (!IsSupportedCompressedFormat(image.internalFormat))
+        {
+            error = "unsupported DDS pixel format (BC1 needs GL_EXT_texture_compression_s3tc, or use BC4)";
+            return false;
+        }
+        image.compressed = true;
+        if (!ReadCompressedLevels(file, offset, width, height, levelCount, image))
+        {
+            error = "DDS file is truncated";
+            return false;
+        }
+        return true;
+    }
+
+    bool LoadKtx(const std::vector<unsigned char>& file, TextureImage& image, std::string& error)
+    {
+        if (file.size() < KtxHeaderSize || !std::equal(std::begin(KtxIdentifier), std::end(KtxIdentifier), file.begin()))
+        {
+            error = "not a KTX 1.1 file";
+            return false;
+        }
+        if (ReadU32(file, 12) != KtxEndianness)
+        {
+            error = "big-endian KTX files are not supported";
+            return false;
+        }
+        uint32_t type = ReadU32(file, 16);
+        uint32_t format = ReadU32(file, 24);
+        uint32_t internalFormat = ReadU32(file, 28);
+        int width = static_cast<int>(ReadU32(file, 36));
+        int height = static_cast<int>(ReadU32(file, 40));
+        uint32_t depth = ReadU32(file, 44);
+        uint32_t arrayElements = ReadU32(file, 48);
+        uint32_t faces = ReadU32(file, 52);
+        int levelCount = std::max(static_cast<int>(ReadU32(file, 56)), 1);
+        uint32_t keyValueBytes = ReadU32(file, 60);
+        if (height == 0 || depth > 0 || arrayElements > 0 || faces != 1)
+        {
+            error = "only 2D KTX textures are supported, give one file per layer";
+            return false;
+        }
+
+        image.internalFormat = internalFormat;
+        image.compressed = type == 0;
+        if (image.compressed ? !IsSupportedCompressedFormat(internalFormat) : type != GL_UNSIGNED_BYTE)
+        {
+            error = "unsupported KTX format";
+            return false;
+        }
+        if (!image.compressed && format != GL_RED && format != GL_RG && format != GL_RGB && format != GL_RGBA)
+        {
+            error = "unsupported KTX format";
+            return false;
+        }
+        image.format = image.compressed ? 0 : format;
+        image.type = image.compressed ? 0 : type;
+
+        // Every level is prefixed with its size and padded to 4 bytes, like GL's default unpack alignment
+        size_t offset = KtxHeaderSize + keyValueBytes;
+        for (int level = 0; level < levelCount; ++level)
+        {
+            size_t size = ReadU32(file, offset);
+            offset += 4;
+            if (offset + size > file.size())
+            {
+                error = "KTX file is truncated";
+                return false;
+            }
+            TextureImage::Level mip;
+            mip.width = std::max(width >> level, 1);
+            mip.height = std::max(height >> level, 1);
+            image.levels.push_back(std::move(mip));
+
+            // Uploads read whole rows of the level, so any other size means a broken or mislabelled file
+            TextureImage::Level& stored = image.levels.back();
+            size_t rows = static_cast<size_t>((stored.height + image.GetRowHeight() - 1) / image.GetRowHeight());
+            if (size != image.GetRowBytes(level) * rows)
+            {
+                error = "KTX level " + std::to_string(level) + " doesn't match the size of its format and dimensions";
+                return false;
+            }
+            stored.data.assign(file.begin() + offset, file.begin() + offset + size);
+            offset += (size + 3) & ~static_cast<size_t>(3);
+        }
+        return true;
+    }
+
+    // Uncompressed formats stb_image can produce, by channel count
+    const unsigned int StbInternalFormats[4] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+    const unsigned int StbFormats[4] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+
+    bool LoadStb(const std::string& filepath, TextureImage& image, int channels, std::string& error)
+    {
+        // Flips the image so it appears right side up
+        stbi_set_flip_vertically_on_load_thread(1);
+
+        TextureImage::Level level;
+        int components = 0;
+        unsigned char* pixels = stbi_load(filepath.c_str(), &level.width, &level.height, &components, channels);
+        if (!pixels)
+        {
+            error = stbi_failure_reason();
+            return false;
+        }
+        level.data.assign(pixels, pixels + static_cast<size_t>(level.width) * level.height * channels);
+        stbi_image_free(pixels);
+
+        // stb_image packs rows tightly, which only matches GL's default alignment of 4 for RGBA
+        image.internalFormat = StbInternalFormats[channels - 1];
+        image.format = StbFormats[channels - 1];
+        image.type = GL_UNSIGNED_BYTE;
+        image.compressed = false;
+        image.unpackAlignment = channels == 4 ? 4 : 1;
+        image.levels.push_back(std::move(level));
+        return true;
+    }
+}
+
+bool TextureImage::Load(const std::string& filepath, TextureImage& image, int channels)
+{
+    image = TextureImage();
+    std::string error;
+    bool loaded = false;
+    if (HasExtension(filepath, ".dds") || HasExtension(filepath, ".ktx"))
+    {
+        std::ifstream stream(filepath, std::ios::binary);
+        std::vector<unsigned char> file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+        if (file.empty())
+        {
+            error = "can't read the file";
+        }
+        else
+        {
+            loaded = HasExtension(filepath, ".dds") ? LoadDds(file, image, error) : LoadKtx(file, image, error);
+        }
+    }
+    else
+    {
+        loaded = LoadStb(filepath, image, std::clamp(channels, 1, 4), error);
+    }
+
+    if (!loaded || image.levels.empty() || image.levels[0].width <= 0 || image.levels[0].height <= 0)
+    {
+        std::cout << "Failed to load texture " << filepath << ": " << (error.empty() ? "empty image" : error) << std::endl;
+        image = TextureImage();
+        return false;
+    }
+    return true;
+}
+
+size_t TextureImage::GetRowBytes(int level) const
+{
+    int width = levels[level].width;
+    if (compressed)
+    {
+        return CompressedLevelSize(width, 1);
+    }
+
+    size_t texelBytes = 4;
+    switch (format)
+    {
+        case GL_RED:
+            texelBytes = 1;
+            break;
+        case GL_RG:
+            texelBytes = 2;
+            break;
+        case GL_RGB:
+            texelBytes = 3;
+            break;
+        default:
+            break;
+    }
+    size_t alignment = static_cast<size_t>(unpackAlignment);
+    return (static_cast<size_t>(width) * texelBytes + alignment - 1) / alignment * alignment;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Pixels of one image file with its mip chain, ready for glTexImage* or glCompressedTexImage*.
+// PNG/JPG/... go through stb_image with the requested number of channels (R8, RG8, RGB8 or RGBA8)
+// and a single level, flipped so row 0 is the bottom.
+// DDS (DXT1, ATI1/BC4U or DX10 BC1/BC4) and KTX 1.1 files keep their compressed blocks and
+// precomputed mipmaps and are uploaded as stored, so they must already be authored bottom row first.
+struct TextureImage
+{
+    struct Level
+    {
+        int width = 0;
+        int height = 0;
+        std::vector<unsigned char> data;
+    };
+
+    unsigned int internalFormat = 0;
+    unsigned int format = 0;  // Client format and type of uncompressed levels, unused when compressed
+    unsigned int type = 0;
+    bool compressed = false;
+    int unpackAlignment = 4;  // GL_UNPACK_ALIGNMENT the rows are padded to
+    std::vector<Level> levels;  // Level 0 first; a single uncompressed level gets its mipmaps generated
+
+    // Reports the reason and returns false if the file can't be read or holds an unsupported format.
+    // Safe to call from worker threads; it touches no GL state. 'channels' (1 to 4) only applies to
+    // images decoded by stb_image; DDS and KTX files keep the format they were stored in.
+    static bool Load(const std::string& filepath, TextureImage& image, int channels = 4);
+
+    // Levels are stored as rows of texels, or of 4x4 blocks when compressed, each padded to
+    // 'unpackAlignment' bytes, so any run of whole rows can be uploaded on its own
+    inline int GetRowHeight() const { return compressed ? 4 : 1; }
+    size_t GetRowBytes(int level) const;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single producer / single consumer triple buffer.
+// The producer fills GetWriteBuffer() and calls Publish(); the consumer calls Acquire()
+// and reads GetReadBuffer(). Neither side ever waits, the consumer always sees the latest
+// published value and intermediate values are dropped.
+template<typename T>
+class TripleBuffer
+{
+    private:
+        static const uint8_t DirtyBit = 0x4;
+        static const uint8_t IndexMask = 0x3;
+
+        T m_Buffers[3];
+        uint8_t m_WriteIndex;
+        uint8_t m_ReadIndex;
+        std::atomic<uint8_t> m_Middle;  // Index of the spare buffer, DirtyBit set if it holds unread data
+    public:
+        TripleBuffer()
+            : m_WriteIndex(0), m_ReadIndex(1), m_Middle(2) {}
+
+        inline T& GetWriteBuffer() { return m_Buffers[m_WriteIndex]; }
+        inline const T& GetReadBuffer() const { return m_Buffers[m_ReadIndex]; }
+
+        void Publish()
+        {
+            uint8_t previous = m_Middle.exchange(static_cast<uint8_t>(m_WriteIndex | DirtyBit), std::memory_order_acq_rel);
+            m_WriteIndex = previous & IndexMask;
+        }
+
+        // Returns true if a newer buffer was published since the last call
+        bool Acquire()
+        {
+            if (!(m_Middle.load(std::memory_order_relaxed) & DirtyBit))
+            {
+                return false;
+            }
+            uint8_t previous = m_Middle.exchange(m_ReadIndex, std::memory_order_acq_rel);
+            m_ReadIndex = previous & IndexMask;
+            return true;
+        }
+};
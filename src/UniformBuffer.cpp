@@ -0,0 +1,38 @@
+#include <UniformBuffer.h>
+#include <GLStateCache.h>
+
+UniformBuffer::UniformBuffer(const void* data, unsigned int size)
+    : m_Size(size)
+{
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLStateCache::BindBuffer(GL_UNIFORM_BUFFER, m_RendererID);
+    GLCall(glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW));
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    GLStateCache::ForgetBuffer(m_RendererID);
+    GLCall(glDeleteBuffers(1, &m_RendererID));
+}
+
+void UniformBuffer::SetData(const void* data, unsigned int size, unsigned int offset)
+{
+    ASSERT(offset + size <= m_Size);
+    Bind();
+    GLCall(glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data));
+}
+
+void UniformBuffer::BindBase(unsigned int binding) const
+{
+    GLStateCache::BindBufferBase(GL_UNIFORM_BUFFER, binding, m_RendererID);
+}
+
+void UniformBuffer::Bind() const
+{
+    GLStateCache::BindBuffer(GL_UNIFORM_BUFFER, m_RendererID);
+}
+
+void UniformBuffer::Unbind() const
+{
+    GLStateCache::BindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <Debugger.h>
+
+// UBO
+class UniformBuffer
+{
+    private:
+        unsigned int m_RendererID;
+        unsigned int m_Size;
+    public:
+        UniformBuffer(const void* data, unsigned int size);
+        ~UniformBuffer();
+
+        void SetData(const void* data, unsigned int size, unsigned int offset = 0);
+        void BindBase(unsigned int binding) const;
+
+        void Bind() const;
+        void Unbind() const;
+};
@@ -1,4 +1,5 @@
 #include <VertexArray.h>
+#include <GLStateCache.h>
 #include <VertexBufferLayout.h>
 
 VertexArray::VertexArray()
@@ -8,6 +9,7 @@ VertexArray::VertexArray()
 
 VertexArray::~VertexArray()
 {
+    GLStateCache::ForgetVertexArray(m_RendererID);
     GLCall(glDeleteVertexArrays(1, &m_RendererID));
 }
         
@@ -15,23 +17,38 @@ void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& la
 {
     Bind();
     vb.Bind();
+    SetAttributes(layout, 0, 0, 0);
+}
+
+void VertexArray::SetAttributes(const VertexBufferLayout& layout, unsigned int firstAttribute, uintptr_t offset, unsigned int divisor) const
+{
+    Bind();
     const auto& elements = layout.GetElements();
-    unsigned int offset = 0;
     for (unsigned int i = 0; i < elements.size(); i ++)
     {
         const auto& element = elements[i];
-        GLCall(glEnableVertexAttribArray(i));
-        GLCall(glVertexAttribPointer(i, element.count, element.type, element.normalized, layout.GetStride(), (const void*) (uintptr_t) offset));
+        unsigned int index = firstAttribute + i;
+        GLCall(glEnableVertexAttribArray(index));
+        if (element.type == GL_UNSIGNED_INT)
+        {
+            // Integer attributes ('in uint') must not go through float conversion
+            GLCall(glVertexAttribIPointer(index, element.count, element.type, layout.GetStride(), (const void*) offset));
+        }
+        else
+        {
+            GLCall(glVertexAttribPointer(index, element.count, element.type, element.normalized, layout.GetStride(), (const void*) offset));
+        }
+        GLCall(glVertexAttribDivisor(index, divisor));
         offset += element.count * VertexBufferElement::GetSizeOfType(element.type);
     }
 }
 
 void VertexArray::Bind() const
 {
-    GLCall(glBindVertexArray(m_RendererID));
+    GLStateCache::BindVertexArray(m_RendererID);
 }
 
 void VertexArray::Unbind() const
 {
-    GLCall(glBindVertexArray(0));
+    GLStateCache::BindVertexArray(0);
 }
\ No newline at end of file
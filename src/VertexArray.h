@@ -4,6 +4,8 @@
 #include <VertexBuffer.h>
 #include <VertexBufferLayout.h>
 
+#include <cstdint>
+
 // VAO
 class VertexArray
 {
@@ -15,6 +17,12 @@ class VertexArray
         
         void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
 
+        // Points attributes firstAttribute.. at 'layout' starting 'offset' bytes into the buffer bound to
+        // GL_ARRAY_BUFFER; divisor 1 advances them per instance instead of per vertex
+        void SetAttributes(const VertexBufferLayout& layout, unsigned int firstAttribute, uintptr_t offset, unsigned int divisor) const;
+
         void Bind() const;
         void Unbind() const;
+
+        inline unsigned int GetRendererID() const { return m_RendererID; }
 };
\ No newline at end of file
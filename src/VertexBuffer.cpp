@@ -1,23 +1,25 @@
 #include <VertexBuffer.h>
+#include <GLStateCache.h>
 
 VertexBuffer::VertexBuffer(const void* data, unsigned int size)
 {
     GLCall(glGenBuffers(1, &m_RendererID));
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+    GLStateCache::BindBuffer(GL_ARRAY_BUFFER, m_RendererID);
     GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
 }
 
 VertexBuffer::~VertexBuffer()
 {
+    GLStateCache::ForgetBuffer(m_RendererID);
     GLCall(glDeleteBuffers(1, &m_RendererID));
 }
 
 void VertexBuffer::Bind() const
 {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+    GLStateCache::BindBuffer(GL_ARRAY_BUFFER, m_RendererID);
 }
 
 void VertexBuffer::Unbind() const
 {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    GLStateCache::BindBuffer(GL_ARRAY_BUFFER, 0);
 }
\ No newline at end of file
@@ -55,6 +55,7 @@ inline void VertexBufferLayout::Push<float>(unsigned int count)
     m_Stride += count * VertexBufferElement::GetSizeOfType(GL_FLOAT);
 }
 
+// Integer attribute, read as 'in uint' in the shader
 template<>
 inline void VertexBufferLayout::Push<unsigned int>(unsigned int count)
 {
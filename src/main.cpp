@@ -4,18 +4,37 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <Debugger.h>
-#include <VertexBuffer.h>
-#include <VertexBufferLayout.h>
-#include <IndexBuffer.h>
-#include <VertexArray.h>
+#include <GLExtensions.h>
+#include <GLStateCache.h>
+#include <UniformBuffer.h>
 #include <Shader.h>
 #include <Texture.h>
+#include <AssetLoader.h>
 #include <Camera.h>
+#include <Frustum.h>
 #include <RubiksCube.h>
+#include <CubeScene.h>
+#include <CubieMesh.h>
+#include <FixedTimestep.h>
+#include <InputLog.h>
+#include <Profiler.h>
+#include <Renderer.h>
+#include <StickerAtlas.h>
+#include <TripleBuffer.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 /* Window size */
 const unsigned int width = 800;
@@ -23,57 +42,70 @@ const unsigned int height = 800;
 const float near = 0.1f;
 const float far = 100.0f;
 
-/* Cube vertices: positions, colors, texCoords, faceId */
-float vertices[] = {
-    // Front face
-    -0.5f, -0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 0.0f,  4.0f,
-     0.5f, -0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 0.0f,  4.0f,
-     0.5f,  0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 1.0f,  4.0f,
-    -0.5f,  0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 1.0f,  4.0f,
-    // Back face
-     0.5f, -0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 0.0f,  5.0f,
-    -0.5f, -0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 0.0f,  5.0f,
-    -0.5f,  0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 1.0f,  5.0f,
-     0.5f,  0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 1.0f,  5.0f,
-    // Left face
-    -0.5f, -0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 0.0f,  1.0f,
-    -0.5f, -0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 0.0f,  1.0f,
-    -0.5f,  0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 1.0f,  1.0f,
-    -0.5f,  0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 1.0f,  1.0f,
-    // Right face
-     0.5f, -0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 0.0f,  0.0f,
-     0.5f, -0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 0.0f,  0.0f,
-     0.5f,  0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 1.0f,  0.0f,
-     0.5f,  0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 1.0f,  0.0f,
-    // Top face
-    -0.5f,  0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 0.0f,  2.0f,
-     0.5f,  0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 0.0f,  2.0f,
-     0.5f,  0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 1.0f,  2.0f,
-    -0.5f,  0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 1.0f,  2.0f,
-    // Bottom face
-    -0.5f, -0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 0.0f,  3.0f,
-     0.5f, -0.5f, -0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 0.0f,  3.0f,
-     0.5f, -0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   1.0f, 1.0f,  3.0f,
-    -0.5f, -0.5f,  0.5f,   1.0f, 1.0f, 1.0f,   0.0f, 1.0f,  3.0f
+/* GL objects used to draw a frame, only touched by the thread that owns the context */
+struct RenderContext
+{
+    Shader* shader = nullptr;
+    Shader* pickingShader = nullptr;
+    Shader* lodShader = nullptr;
+    Shader* proceduralShader = nullptr;
+    const CubieMesh* mesh = nullptr;
+    StickerAtlas* atlas = nullptr;
+    Texture* texture = nullptr;
+    AssetLoader* assets = nullptr;
+    UniformBuffer* palette = nullptr;
+    Renderer* renderer = nullptr;
+    std::atomic<int>* stickerStyleCount = nullptr;  /* Layers of 'texture' as of the last frame, for the input thread */
+};
+
+/* Camera, framebuffer and render settings for one frame; the cubes publish their own snapshots */
+struct ViewSnapshot
+{
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 proj = glm::mat4(1.0f);
+    int fbWidth = 0;
+    int fbHeight = 0;
+    bool depthPrepass = false;
+    float lodPixels = 0.0f;
+    int stickerStyle = 0;
+    bool proceduralStickers = false;
 };
 
-unsigned int indices[] = {
-    0, 1, 2, 2, 3, 0,       // Front
-    4, 5, 6, 6, 7, 4,       // Back
-    8, 9, 10, 10, 11, 8,    // Left
-    12, 13, 14, 14, 15, 12, // Right
-    16, 17, 18, 18, 19, 16, // Top
-    20, 21, 22, 22, 23, 20  // Bottom
+/* std140 layout of the StickerShape block in res/shaders/sticker.glsl */
+struct StickerShapeBlock
+{
+    glm::vec2 halfSize = glm::vec2(0.5f);  /* Of the rounded rectangle, in face texture coordinates */
+    float cornerRadius = 0.0f;
+    float padding = 0.0f;
+};
+
+/* Picking requests from the input thread, answered by the render thread */
+struct PickMailbox
+{
+    std::mutex mutex;
+    bool requested = false;
+    bool answered = false;
+    glm::vec2 pixel = glm::vec2(0.0f);
+    int id = -1;
+    float depth = 1.0f;
+};
+
+/* State shared between the input/simulation thread and the render thread */
+struct RenderThreadShared
+{
+    CubeScene* scene = nullptr;
+    TripleBuffer<ViewSnapshot> views;
+    PickMailbox pick;
+    std::atomic<bool> quit{ false };
 };
 
 struct AppState
 {
     Camera* camera = nullptr;
-    RubiksCube* rubiks = nullptr;
-    Shader* shader = nullptr;
-    VertexArray* va = nullptr;
-    IndexBuffer* ib = nullptr;
-    Texture* texture = nullptr;
+    CubeScene* scene = nullptr;
+    RubiksCube* rubiks = nullptr;  /* The puzzle driven by the keyboard and picking, the scene's first */
+    RenderContext* render = nullptr;
+    PickMailbox* pickMailbox = nullptr;
     bool pickingMode = false;
     int selectedCubeId = -1;
     float pickDepth = 1.0f;
@@ -83,23 +115,82 @@ struct AppState
     bool rotateClockwise = true;
     int turnAngle = 90;
     glm::vec3 dragOffset = glm::vec3(0.0f);
+    uint64_t tick = 0;
+    InputLog* recorder = nullptr;
+    bool replaying = false;
+    /* As of the last resize event, so a replay maps the cursor like the recorded session did */
+    glm::ivec2 windowSize = glm::ivec2(0);
+    glm::ivec2 framebufferSize = glm::ivec2(0);
+    bool depthPrepass = false;
+    float lodPixels = 0.0f;  /* Puzzles with a smaller on-screen radius are drawn as one textured box */
+    int stickerStyle = 0;  /* Layer of the sticker texture used by the first puzzle (modulo the layer count), the next ones cycle on */
+    std::atomic<int> stickerStyleCount{ 1 };  /* Published by the render side, the texture may still be streaming in */
+    bool proceduralStickers = false;  /* Sticker shape computed in the shader, no mask texture */
+    bool wall = false;  /* Many self-playing puzzles, view only */
+    float farPlane = far;
 };
 
-static glm::vec4 EncodeIdColor(int id)
-{
-    int idx = id + 1;
-    int r = (idx & 0xFF);
-    int g = (idx >> 8) & 0xFF;
-    int b = (idx >> 16) & 0xFF;
-    return glm::vec4(r / 255.0f, g / 255.0f, b / 255.0f, 1.0f);
-}
-
+/* Inverse of EncodePickId in res/shaders/picking.glsl */
 static int DecodeIdColor(unsigned char r, unsigned char g, unsigned char b)
 {
     int idx = static_cast<int>(r) + (static_cast<int>(g) << 8) + (static_cast<int>(b) << 16);
     return idx == 0 ? -1 : idx - 1;
 }
 
+static const char* AnimationModeName(RubiksCube::AnimationMode mode)
+{
+    switch (mode)
+    {
+        case RubiksCube::AnimationAdaptive:
+            return "adaptive";
+        case RubiksCube::AnimationInstant:
+            return "instant";
+        default:
+            return "normal";
+    }
+}
+
+static bool ParseAnimationMode(const std::string& name, RubiksCube::AnimationMode& mode)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        RubiksCube::AnimationMode candidate = static_cast<RubiksCube::AnimationMode>(i);
+        if (name == AnimationModeName(candidate))
+        {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* The whole argument must be a number, so a typo is reported instead of read as its prefix */
+static bool ParseFloat(const char* text, float& value)
+{
+    char* end = nullptr;
+    errno = 0;
+    float parsed = std::strtof(text, &end);
+    if (end == text || *end != '\0' || errno == ERANGE)
+    {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+static bool ParseInt(const char* text, int& value)
+{
+    char* end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || parsed < INT_MIN || parsed > INT_MAX)
+    {
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    return true;
+}
+
 static int DefaultDirectionForLayer(int layer)
 {
     return layer == 1 ? -1 : 1;
@@ -107,7 +198,8 @@ static int DefaultDirectionForLayer(int layer)
 
 static void TryStartRotation(AppState* state, RubiksCube::Axis axis, int layer)
 {
-    if (!state || state->rubiks->IsRotating())
+    /* The puzzles of a wall play their own moves */
+    if (!state || state->wall)
     {
         return;
     }
@@ -116,23 +208,187 @@ static void TryStartRotation(AppState* state, RubiksCube::Axis axis, int layer)
     {
         dir = -dir;
     }
-    state->rubiks->StartRotation(axis, layer, dir, static_cast<float>(state->turnAngle));
+
+    /* Queue instead of dropping the key press; the queue cancels and merges redundant turns */
+    CubeMove move;
+    move.axis = axis;
+    move.layer = layer;
+    move.turns = dir * (state->turnAngle / 90);
+    state->rubiks->QueueMove(move);
+}
+
+static void BuildViewSnapshot(const AppState* state, ViewSnapshot& snapshot)
+{
+    snapshot.fbWidth = state->framebufferSize.x;
+    snapshot.fbHeight = state->framebufferSize.y;
+    snapshot.view = state->camera->GetViewMatrix();
+    snapshot.proj = state->camera->GetProjectionMatrix();
+    snapshot.depthPrepass = state->depthPrepass;
+    snapshot.lodPixels = state->lodPixels;
+    snapshot.stickerStyle = state->stickerStyle;
+    snapshot.proceduralStickers = state->proceduralStickers;
+}
+
+/* Records the visible stickers and bodies of every puzzle; the renderer merges them into instanced draws.
+   Puzzles outside the view are skipped whole, cubies are only tested when their puzzle straddles the view.
+   Puzzles smaller on screen than view.lodPixels (radius) become one box textured from the sticker atlas.
+   'picking' draws ids with the picking program, which also serves as the depth prepass. */
+static void SubmitScene(const RenderContext& ctx, const ViewSnapshot& view, const CubeScene& scene, bool picking)
+{
+    Shader& stickerShader = view.proceduralStickers ? *ctx.proceduralShader : *ctx.shader;
+    Shader& shader = picking ? *ctx.pickingShader : stickerShader;
+    Shader& lodShader = picking ? *ctx.pickingShader : *ctx.lodShader;
+    const Texture* texture = (picking || view.proceduralStickers) ? nullptr : ctx.texture;
+    const Texture* lodTexture = picking ? nullptr : &ctx.atlas->GetTexture();
+    const VertexArray& va = ctx.mesh->GetVertexArray();
+    const IndexBuffer& ib = ctx.mesh->GetIndexBuffer();
+    glm::mat4 viewProj = view.proj * view.view;
+    /* Pixels per unit of view-space size at distance 1 */
+    float pixelScale = 0.5f * static_cast<float>(view.fbHeight) * view.proj[1][1];
+    int styleCount = std::max(ctx.texture->GetLayerCount(), 1);
+    ctx.stickerStyleCount->store(styleCount, std::memory_order_relaxed);
+    Frustum frustum(viewProj);
+    ctx.renderer->Begin(viewProj);
+    for (int puzzle = 0; puzzle < scene.GetPuzzleCount(); ++puzzle)
+    {
+        const RubiksCube::Snapshot& cubes = scene.GetPuzzle(puzzle).GetSnapshot();
+        const glm::mat4& placement = scene.GetPlacement(puzzle);
+        Frustum::Result visibility = frustum.TestSphere(glm::vec3(placement[3]), cubes.boundsRadius);
+        if (visibility == Frustum::Outside)
+        {
+            continue;
+        }
+
+        /* A cubie out of place can't be shown by the baked stickers */
+        glm::vec4 center = viewProj * placement[3];
+        if (cubes.intact && center.w > 0.0f && cubes.boundsRadius * pixelScale < view.lodPixels * center.w)
+        {
+            if (!picking)
+            {
+                ctx.atlas->Update(puzzle, cubes);
+            }
+
+            InstanceData instance;
+            instance.model = placement * cubes.boxModel;
+            instance.facePalette = static_cast<uint32_t>(puzzle);  /* The LOD program reads it as the atlas tile */
+            instance.pickId = InstanceData::NoPickId;
+            instance.style = 0;
+            ctx.renderer->Submit(lodShader, va, ib, ctx.mesh->GetCubeRange(), lodTexture, instance, center.z / center.w * 0.5f + 0.5f);
+            continue;
+        }
+
+        /* Neighbouring puzzles show different sticker styles, all from the one bound texture array */
+        uint32_t style = static_cast<uint32_t>((view.stickerStyle + puzzle) % styleCount);
+        for (int i = 0; i < cubes.cubeCount; ++i)
+        {
+            /* Internal faces are only drawn when a cubie out of place may expose them; on an intact
+               puzzle the core has no sticker faces, so its empty range is what skips the hidden core */
+            const MeshRange& range = cubes.intact ? ctx.mesh->GetStickerRange(cubes.facePalettes[i]) : ctx.mesh->GetCubeRange();
+            if (range.indexCount == 0)
+            {
+                continue;
+            }
+
+            InstanceData instance;
+            instance.model = placement * cubes.models[i];
+            if (visibility == Frustum::Intersecting && !frustum.IntersectsSphere(glm::vec3(instance.model[3]), cubes.cubieRadius))
+            {
+                continue;
+            }
+            instance.facePalette = cubes.facePalettes[i];
+            instance.pickId = static_cast<uint32_t>(puzzle * CubeState::CubieCount + i);
+            instance.style = style;
+
+            glm::vec4 clip = viewProj * instance.model[3];
+            float depth = clip.w > 0.0f ? clip.z / clip.w * 0.5f + 0.5f : 0.0f;
+            ctx.renderer->Submit(shader, va, ib, range, texture, instance, depth);
+        }
+
+        /* Black bodies behind the stickers, all faces use palette entry 0 */
+        for (int i = 0; i < cubes.bodyCount; ++i)
+        {
+            InstanceData instance;
+            instance.model = placement * cubes.bodyModels[i];
+            instance.facePalette = 0;
+            instance.pickId = InstanceData::NoPickId;
+            instance.style = style;
+
+            glm::vec4 clip = viewProj * instance.model[3];
+            float depth = clip.w > 0.0f ? clip.z / clip.w * 0.5f + 0.5f : 0.0f;
+            ctx.renderer->Submit(shader, va, ib, ctx.mesh->GetCubeRange(), texture, instance, depth);
+        }
+    }
+    ctx.renderer->Flush();
+}
+
+static void RenderPicking(const RenderContext& ctx, const ViewSnapshot& view, const CubeScene& scene, glm::vec2 pixel, int& id, float& depth)
+{
+    int px = std::clamp(static_cast<int>(pixel.x), 0, std::max(view.fbWidth - 1, 0));
+    int py = std::clamp(static_cast<int>(pixel.y), 0, std::max(view.fbHeight - 1, 0));
+
+    /* Only the pixel under the cursor is read back, so clear and shade nothing else */
+    GLCall(glViewport(0, 0, view.fbWidth, view.fbHeight));
+    GLStateCache::SetEnabled(GL_SCISSOR_TEST, true);
+    GLCall(glScissor(px, py, 1, 1));
+    GLStateCache::SetEnabled(GL_DEPTH_TEST, true);
+    GLCall(glDepthFunc(GL_LESS));
+    GLCall(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
+    GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+
+    SubmitScene(ctx, view, scene, true);
+
+    /* glReadPixels waits for the draws itself */
+    unsigned char color[4] = { 0, 0, 0, 0 };
+    GLCall(glReadPixels(px, py, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, color));
+
+    depth = 1.0f;
+    GLCall(glReadPixels(px, py, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &depth));
+
+    GLStateCache::SetEnabled(GL_SCISSOR_TEST, false);
+
+    id = DecodeIdColor(color[0], color[1], color[2]);
 }
 
-static void PerformPicking(GLFWwindow* window, AppState* state, double mouseX, double mouseY)
+static void RenderFrame(const RenderContext& ctx, const ViewSnapshot& view, const CubeScene& scene)
+{
+    GLCall(glViewport(0, 0, view.fbWidth, view.fbHeight));
+
+    /* Set white background color */
+    GLCall(glClearColor(0.05f, 0.05f, 0.05f, 1.0f));
+
+    /* Render here */
+    GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+
+    /* Depth prepass: lay down depth with the untextured picking program, then shade each pixel once */
+    if (view.depthPrepass)
+    {
+        GLCall(glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE));
+        SubmitScene(ctx, view, scene, true);
+        GLCall(glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE));
+        GLCall(glDepthMask(GL_FALSE));
+        GLCall(glDepthFunc(GL_LEQUAL));
+    }
+
+    SubmitScene(ctx, view, scene, false);
+
+    if (view.depthPrepass)
+    {
+        GLCall(glDepthMask(GL_TRUE));
+        GLCall(glDepthFunc(GL_LESS));
+    }
+}
+
+static void PerformPicking(AppState* state, double mouseX, double mouseY)
 {
     if (!state)
     {
         return;
     }
 
-    int winWidth = 0;
-    int winHeight = 0;
-    glfwGetWindowSize(window, &winWidth, &winHeight);
-
-    int fbWidth = 0;
-    int fbHeight = 0;
-    glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+    int winWidth = state->windowSize.x;
+    int winHeight = state->windowSize.y;
+    int fbWidth = state->framebufferSize.x;
+    int fbHeight = state->framebufferSize.y;
 
     float sx = winWidth > 0 ? static_cast<float>(fbWidth) / static_cast<float>(winWidth) : 1.0f;
     float sy = winHeight > 0 ? static_cast<float>(fbHeight) / static_cast<float>(winHeight) : 1.0f;
@@ -141,58 +397,131 @@ static void PerformPicking(GLFWwindow* window, AppState* state, double mouseX, d
     float mouseYFB = static_cast<float>(mouseY) * sy;
     float mouseYGL = static_cast<float>(fbHeight) - mouseYFB - 1.0f;
 
-    GLCall(glEnable(GL_DEPTH_TEST));
-    GLCall(glDepthFunc(GL_LESS));
-    GLCall(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
-    GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+    /* With a render thread the GL context lives there, so post the request and pick up the answer later */
+    if (state->pickMailbox)
+    {
+        std::lock_guard<std::mutex> lock(state->pickMailbox->mutex);
+        state->pickMailbox->requested = true;
+        state->pickMailbox->answered = false;
+        state->pickMailbox->pixel = glm::vec2(mouseXFB, mouseYGL);
+        return;
+    }
 
-    glm::mat4 view = state->camera->GetViewMatrix();
-    glm::mat4 proj = state->camera->GetProjectionMatrix();
+    ViewSnapshot view;
+    BuildViewSnapshot(state, view);
+    state->scene->PublishSnapshots(1.0f);
+    state->scene->AcquireSnapshots();
+    RenderPicking(*state->render, view, *state->scene, glm::vec2(mouseXFB, mouseYGL), state->selectedCubeId, state->pickDepth);
+}
 
-    state->shader->Bind();
-    state->shader->SetUniform1i("u_Picking", 1);
-    state->shader->SetUniform1i("u_Texture", 0);
+static void ApplyPickResult(AppState* state)
+{
+    std::lock_guard<std::mutex> lock(state->pickMailbox->mutex);
+    if (state->pickMailbox->answered)
+    {
+        state->selectedCubeId = state->pickMailbox->id;
+        state->pickDepth = state->pickMailbox->depth;
+        state->pickMailbox->answered = false;
+    }
+}
 
-    state->va->Bind();
-    state->ib->Bind();
+/* Developer check (--check-shaders): build every permutation of basic.shader, including those nothing
+   draws with yet, so a broken #ifdef branch shows up before someone first selects it */
+static bool CheckShaderPermutations()
+{
+    const std::vector<std::vector<std::string>> variants = { {}, { "PICKING" }, { "LOD" }, { "PROCEDURAL_STICKER" } };
+    bool ok = true;
+    for (const char* instanced : { "", "INSTANCED" })
+    {
+        for (std::vector<std::string> defines : variants)
+        {
+            if (*instanced)
+            {
+                defines.insert(defines.begin(), instanced);
+            }
+            Shader permutation("res/shaders/basic.shader", defines);
+            if (!permutation.IsLinked())
+            {
+                std::cout << "Shader permutation {";
+                for (size_t i = 0; i < defines.size(); ++i)
+                {
+                    std::cout << (i > 0 ? ", " : " ") << defines[i];
+                }
+                std::cout << " } of res/shaders/basic.shader failed to build" << std::endl;
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
 
-    for (const auto& cube : state->rubiks->GetCubes())
+/* Swap in edited shaders once they link; uniforms and block bindings are program state and must be set again */
+static void ReloadShaders(const RenderContext& ctx)
+{
+    if (ctx.shader->PollReload())
+    {
+        ctx.shader->SetUniformBlockBinding("Palette", 0);
+        ctx.shader->Bind();
+        ctx.shader->SetUniform1i("u_Texture", 0);
+    }
+    if (ctx.proceduralShader->PollReload())
     {
-        glm::mat4 model = state->rubiks->GetCubeModel(cube.id);
-        glm::mat4 mvp = proj * view * model;
-        glm::vec4 pickColor = EncodeIdColor(cube.id);
-        state->shader->SetUniform4f("u_Color", pickColor);
-        state->shader->SetUniformMat4f("u_MVP", mvp);
-        GLCall(glDrawElements(GL_TRIANGLES, state->ib->GetCount(), GL_UNSIGNED_INT, nullptr));
+        ctx.proceduralShader->SetUniformBlockBinding("Palette", 0);
+        ctx.proceduralShader->SetUniformBlockBinding("StickerShape", 1);
     }
+    if (ctx.lodShader->PollReload())
+    {
+        ctx.lodShader->Bind();
+        ctx.lodShader->SetUniform1i("u_Texture", 0);
+    }
+    ctx.pickingShader->PollReload();
+}
 
-    GLCall(glFinish());
+static void RenderThreadMain(GLFWwindow* window, RenderContext* ctx, RenderThreadShared* shared)
+{
+    glfwMakeContextCurrent(window);
 
-    int px = static_cast<int>(mouseXFB);
-    int py = static_cast<int>(mouseYGL);
+    while (!shared->quit.load())
+    {
+        shared->views.Acquire();
+        shared->scene->AcquireSnapshots();
+        const ViewSnapshot& view = shared->views.GetReadBuffer();
+        const CubeScene& scene = *shared->scene;
 
-    unsigned char pixel[4] = { 0, 0, 0, 0 };
-    GLCall(glReadPixels(px, py, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel));
+        glm::vec2 pickPixel(0.0f);
+        bool pickRequested = false;
+        {
+            std::lock_guard<std::mutex> lock(shared->pick.mutex);
+            pickRequested = shared->pick.requested;
+            pickPixel = shared->pick.pixel;
+            shared->pick.requested = false;
+        }
+        if (pickRequested)
+        {
+            int id = -1;
+            float depth = 1.0f;
+            RenderPicking(*ctx, view, scene, pickPixel, id, depth);
+
+            std::lock_guard<std::mutex> lock(shared->pick.mutex);
+            shared->pick.id = id;
+            shared->pick.depth = depth;
+            shared->pick.answered = true;
+        }
 
-    float depth = 1.0f;
-    GLCall(glReadPixels(px, py, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &depth));
+        ReloadShaders(*ctx);
+        ctx->assets->Update();
+        RenderFrame(*ctx, view, scene);
+        glfwSwapBuffers(window);
+    }
 
-    int id = DecodeIdColor(pixel[0], pixel[1], pixel[2]);
-    state->selectedCubeId = id;
-    state->pickDepth = depth;
+    glfwMakeContextCurrent(nullptr);
 }
 
-static void KeyCallback(GLFWwindow* window, int key, int scanCode, int action, int mods)
+static void HandleKey(GLFWwindow* window, AppState* state, int key, int action, int mods)
 {
-    AppState* state = static_cast<AppState*>(glfwGetWindowUserPointer(window));
-    if (!state)
-    {
-        return;
-    }
-
     if (action == GLFW_PRESS)
     {
-        if (key == GLFW_KEY_P)
+        if (key == GLFW_KEY_P && !state->wall)
         {
             state->pickingMode = !state->pickingMode;
             state->selectedCubeId = -1;
@@ -213,6 +542,40 @@ static void KeyCallback(GLFWwindow* window, int key, int scanCode, int action, i
             state->turnAngle = std::min(180, state->turnAngle * 2);
             return;
         }
+        if (key == GLFW_KEY_EQUAL || key == GLFW_KEY_MINUS)
+        {
+            float speed = state->rubiks->GetAnimationSpeed();
+            state->scene->SetAnimationSpeed(key == GLFW_KEY_EQUAL ? speed * 2.0f : speed * 0.5f);
+            std::cout << "Animation speed: " << state->rubiks->GetAnimationSpeed() << " deg/s" << std::endl;
+            return;
+        }
+        if (key == GLFW_KEY_F2)
+        {
+            state->depthPrepass = !state->depthPrepass;
+            std::cout << "Depth prepass: " << (state->depthPrepass ? "on" : "off") << std::endl;
+            return;
+        }
+        if (key == GLFW_KEY_F3)
+        {
+            /* Only the style changes here; the texture belongs to the render thread, which wraps it per frame */
+            int styles = std::max(state->stickerStyleCount.load(std::memory_order_relaxed), 1);
+            state->stickerStyle = (state->stickerStyle % styles + 1) % styles;
+            std::cout << "Sticker style: " << state->stickerStyle + 1 << " of " << styles << std::endl;
+            return;
+        }
+        if (key == GLFW_KEY_F4)
+        {
+            state->proceduralStickers = !state->proceduralStickers;
+            std::cout << "Sticker shape: " << (state->proceduralStickers ? "procedural" : "texture") << std::endl;
+            return;
+        }
+        if (key == GLFW_KEY_M)
+        {
+            int mode = (state->rubiks->GetAnimationMode() + 1) % 3;
+            state->scene->SetAnimationMode(static_cast<RubiksCube::AnimationMode>(mode));
+            std::cout << "Animation mode: " << AnimationModeName(state->rubiks->GetAnimationMode()) << std::endl;
+            return;
+        }
 
         if (key == GLFW_KEY_R)
         {
@@ -265,17 +628,8 @@ static void KeyCallback(GLFWwindow* window, int key, int scanCode, int action, i
     }
 }
 
-static void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+static void HandleMouseButton(GLFWwindow* window, AppState* state, int button, int action, double mouseX, double mouseY)
 {
-    AppState* state = static_cast<AppState*>(glfwGetWindowUserPointer(window));
-    if (!state)
-    {
-        return;
-    }
-
-    double mouseX = 0.0;
-    double mouseY = 0.0;
-    glfwGetCursorPos(window, &mouseX, &mouseY);
     state->lastMouse = glm::vec2(static_cast<float>(mouseX), static_cast<float>(mouseY));
 
     if (button == GLFW_MOUSE_BUTTON_LEFT)
@@ -283,7 +637,7 @@ static void MouseButtonCallback(GLFWwindow* window, int button, int action, int
         state->leftDown = (action == GLFW_PRESS);
         if (action == GLFW_PRESS && state->pickingMode && !state->rubiks->IsRotating())
         {
-            PerformPicking(window, state, mouseX, mouseY);
+            PerformPicking(state, mouseX, mouseY);
         }
     }
     else if (button == GLFW_MOUSE_BUTTON_RIGHT)
@@ -291,13 +645,10 @@ static void MouseButtonCallback(GLFWwindow* window, int button, int action, int
         state->rightDown = (action == GLFW_PRESS);
         if (action == GLFW_PRESS && state->pickingMode && state->selectedCubeId >= 0)
         {
-            int winWidth = 0;
-            int winHeight = 0;
-            glfwGetWindowSize(window, &winWidth, &winHeight);
-
-            int fbWidth = 0;
-            int fbHeight = 0;
-            glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+            int winWidth = state->windowSize.x;
+            int winHeight = state->windowSize.y;
+            int fbWidth = state->framebufferSize.x;
+            int fbHeight = state->framebufferSize.y;
 
             float sx = winWidth > 0 ? static_cast<float>(fbWidth) / static_cast<float>(winWidth) : 1.0f;
             float sy = winHeight > 0 ? static_cast<float>(fbHeight) / static_cast<float>(winHeight) : 1.0f;
@@ -318,14 +669,8 @@ static void MouseButtonCallback(GLFWwindow* window, int button, int action, int
     }
 }
 
-static void CursorPosCallback(GLFWwindow* window, double mouseX, double mouseY)
+static void HandleCursorPos(GLFWwindow* window, AppState* state, double mouseX, double mouseY)
 {
-    AppState* state = static_cast<AppState*>(glfwGetWindowUserPointer(window));
-    if (!state)
-    {
-        return;
-    }
-
     float dx = static_cast<float>(mouseX) - state->lastMouse.x;
     float dy = static_cast<float>(mouseY) - state->lastMouse.y;
     state->lastMouse = glm::vec2(static_cast<float>(mouseX), static_cast<float>(mouseY));
@@ -351,13 +696,10 @@ static void CursorPosCallback(GLFWwindow* window, double mouseX, double mouseY)
     {
         if (state->pickingMode && state->selectedCubeId >= 0)
         {
-            int winWidth = 0;
-            int winHeight = 0;
-            glfwGetWindowSize(window, &winWidth, &winHeight);
-
-            int fbWidth = 0;
-            int fbHeight = 0;
-            glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+            int winWidth = state->windowSize.x;
+            int winHeight = state->windowSize.y;
+            int fbWidth = state->framebufferSize.x;
+            int fbHeight = state->framebufferSize.y;
 
             float sx = winWidth > 0 ? static_cast<float>(fbWidth) / static_cast<float>(winWidth) : 1.0f;
             float sy = winHeight > 0 ? static_cast<float>(fbHeight) / static_cast<float>(winHeight) : 1.0f;
@@ -382,34 +724,326 @@ static void CursorPosCallback(GLFWwindow* window, double mouseX, double mouseY)
     }
 }
 
-static void ScrollCallback(GLFWwindow* window, double scrollOffsetX, double scrollOffsetY)
+static void HandleScroll(AppState* state, double scrollOffsetX, double scrollOffsetY)
+{
+    state->camera->Zoom(scrollOffsetY);
+}
+
+static void HandleResize(GLFWwindow* window, AppState* state, const InputEvent& event)
+{
+    glm::ivec2 size(static_cast<int>(event.x), static_cast<int>(event.y));
+    if (event.type == InputEvent::WindowSize)
+    {
+        state->windowSize = size;
+        /* The live window follows the log; its own resize callbacks are ignored while replaying */
+        if (state->replaying)
+        {
+            glfwSetWindowSize(window, size.x, size.y);
+        }
+        return;
+    }
+
+    /* The viewport is set by the renderer from each frame's snapshot */
+    state->framebufferSize = size;
+    state->camera->SetSize(size.x, size.y);
+    state->camera->SetPerspective(45.0f, near, state->farPlane);
+}
+
+static void DispatchInputEvent(GLFWwindow* window, AppState* state, const InputEvent& event)
+{
+    switch (event.type)
+    {
+        case InputEvent::Key:
+            HandleKey(window, state, event.code, event.action, event.mods);
+            break;
+        case InputEvent::MouseButton:
+            HandleMouseButton(window, state, event.code, event.action, event.x, event.y);
+            break;
+        case InputEvent::CursorPos:
+            HandleCursorPos(window, state, event.x, event.y);
+            break;
+        case InputEvent::Scroll:
+            HandleScroll(state, event.x, event.y);
+            break;
+        case InputEvent::WindowSize:
+        case InputEvent::FramebufferSize:
+            HandleResize(window, state, event);
+            break;
+        default:
+            break;
+    }
+}
+
+/* GLFW callbacks: live input is recorded (when enabled) and dispatched, but ignored while replaying */
+static AppState* LiveInputState(GLFWwindow* window)
 {
     AppState* state = static_cast<AppState*>(glfwGetWindowUserPointer(window));
+    return (state && !state->replaying) ? state : nullptr;
+}
+
+static void RecordAndDispatch(GLFWwindow* window, AppState* state, InputEvent event)
+{
+    event.tick = state->tick;
+    if (state->recorder)
+    {
+        state->recorder->Record(event);
+    }
+    DispatchInputEvent(window, state, event);
+}
+
+static void KeyCallback(GLFWwindow* window, int key, int scanCode, int action, int mods)
+{
+    AppState* state = LiveInputState(window);
     if (!state)
     {
         return;
     }
-    state->camera->Zoom(scrollOffsetY);
+
+    InputEvent event;
+    event.type = InputEvent::Key;
+    event.code = key;
+    event.action = action;
+    event.mods = mods;
+    RecordAndDispatch(window, state, event);
 }
 
-static void FramebufferSizeCallback(GLFWwindow* window, int fbWidth, int fbHeight)
+static void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 {
-    GLCall(glViewport(0, 0, fbWidth, fbHeight));
+    AppState* state = LiveInputState(window);
+    if (!state)
+    {
+        return;
+    }
 
-    AppState* state = static_cast<AppState*>(glfwGetWindowUserPointer(window));
-    if (!state || !state->camera)
+    double mouseX = 0.0;
+    double mouseY = 0.0;
+    glfwGetCursorPos(window, &mouseX, &mouseY);
+
+    InputEvent event;
+    event.type = InputEvent::MouseButton;
+    event.code = button;
+    event.action = action;
+    event.mods = mods;
+    event.x = static_cast<float>(mouseX);
+    event.y = static_cast<float>(mouseY);
+    RecordAndDispatch(window, state, event);
+}
+
+static void CursorPosCallback(GLFWwindow* window, double mouseX, double mouseY)
+{
+    AppState* state = LiveInputState(window);
+    if (!state)
+    {
+        return;
+    }
+
+    InputEvent event;
+    event.type = InputEvent::CursorPos;
+    event.x = static_cast<float>(mouseX);
+    event.y = static_cast<float>(mouseY);
+    RecordAndDispatch(window, state, event);
+}
+
+static void ScrollCallback(GLFWwindow* window, double scrollOffsetX, double scrollOffsetY)
+{
+    AppState* state = LiveInputState(window);
+    if (!state)
+    {
+        return;
+    }
+
+    InputEvent event;
+    event.type = InputEvent::Scroll;
+    event.x = static_cast<float>(scrollOffsetX);
+    event.y = static_cast<float>(scrollOffsetY);
+    RecordAndDispatch(window, state, event);
+}
+
+static void WindowSizeCallback(GLFWwindow* window, int winWidth, int winHeight)
+{
+    AppState* state = LiveInputState(window);
+    if (!state)
+    {
+        return;
+    }
+
+    InputEvent event;
+    event.type = InputEvent::WindowSize;
+    event.x = static_cast<float>(winWidth);
+    event.y = static_cast<float>(winHeight);
+    RecordAndDispatch(window, state, event);
+}
+
+static void FramebufferSizeCallback(GLFWwindow* window, int fbWidth, int fbHeight)
+{
+    AppState* state = LiveInputState(window);
+    if (!state)
     {
         return;
     }
 
-    state->camera->SetSize(fbWidth, fbHeight);
-    state->camera->SetPerspective(45.0f, near, far);
+    InputEvent event;
+    event.type = InputEvent::FramebufferSize;
+    event.x = static_cast<float>(fbWidth);
+    event.y = static_cast<float>(fbHeight);
+    RecordAndDispatch(window, state, event);
 }
 
 int main(int argc, char* argv[])
 {
     GLFWwindow* window;
 
+    /* Command line options */
+    float animationSpeed = 180.0f;
+    RubiksCube::AnimationMode animationMode = RubiksCube::AnimationNormal;
+    std::string recordPath;
+    std::string replayPath;
+    bool headless = false;
+    bool renderThread = false;
+    bool watchShaders = false;
+    bool checkShaders = false;
+    bool depthPrepass = false;
+    bool bufferStorage = true;
+    bool multiDraw = true;
+    int wallSize = 0;
+    float lodPixels = 24.0f;
+    bool proceduralStickers = false;
+    std::vector<std::string> stickerFiles = { "res/textures/plane.png" };
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--anim-speed" && i + 1 < argc)
+        {
+            if (!ParseFloat(argv[++i], animationSpeed))
+            {
+                std::cout << "Invalid animation speed: " << argv[i] << " (degrees per second)" << std::endl;
+                return -1;
+            }
+        }
+        else if (arg == "--anim-mode" && i + 1 < argc)
+        {
+            if (!ParseAnimationMode(argv[++i], animationMode))
+            {
+                std::cout << "Unknown animation mode: " << argv[i] << " (normal, adaptive, instant)" << std::endl;
+                return -1;
+            }
+        }
+        else if (arg == "--record" && i + 1 < argc)
+        {
+            recordPath = argv[++i];
+        }
+        else if (arg == "--replay" && i + 1 < argc)
+        {
+            replayPath = argv[++i];
+        }
+        else if (arg == "--headless")
+        {
+            headless = true;
+        }
+        else if (arg == "--render-thread")
+        {
+            renderThread = true;
+        }
+        else if (arg == "--watch-shaders")
+        {
+            watchShaders = true;
+        }
+        else if (arg == "--check-shaders")
+        {
+            checkShaders = true;
+        }
+        else if (arg == "--depth-prepass")
+        {
+            depthPrepass = true;
+        }
+        else if (arg == "--wall" && i + 1 < argc)
+        {
+            if (!ParseInt(argv[++i], wallSize))
+            {
+                std::cout << "Invalid wall size: " << argv[i] << " (number of puzzles)" << std::endl;
+                return -1;
+            }
+            wallSize = std::max(wallSize, 0);
+        }
+        else if (arg == "--stickers" && i + 1 < argc)
+        {
+            /* Comma separated, one texture array layer each */
+            stickerFiles.clear();
+            std::stringstream list(argv[++i]);
+            std::string file;
+            while (std::getline(list, file, ','))
+            {
+                stickerFiles.push_back(file);
+            }
+        }
+        else if (arg == "--lod-pixels" && i + 1 < argc)
+        {
+            if (!ParseFloat(argv[++i], lodPixels))
+            {
+                std::cout << "Invalid LOD radius: " << argv[i] << " (pixels)" << std::endl;
+                return -1;
+            }
+            lodPixels = std::max(lodPixels, 0.0f);
+        }
+        else if (arg == "--procedural-stickers")
+        {
+            proceduralStickers = true;
+        }
+        else if (arg == "--no-buffer-storage")
+        {
+            bufferStorage = false;
+        }
+        else if (arg == "--no-multi-draw")
+        {
+            multiDraw = false;
+        }
+        else
+        {
+            std::cout << "Unknown option: " << arg << std::endl;
+            return -1;
+        }
+    }
+
+    /* A replay restores the settings it was recorded with */
+    InputLog inputLog;
+    bool replaying = !replayPath.empty();
+    if (renderThread && (replaying || !recordPath.empty()))
+    {
+        /* Asynchronous picking would make the recorded session non-deterministic */
+        std::cout << "--render-thread is ignored while recording or replaying" << std::endl;
+        renderThread = false;
+    }
+    if (replaying)
+    {
+        if (!inputLog.Load(replayPath))
+        {
+            return -1;
+        }
+        animationSpeed = inputLog.GetSettings().animationSpeed;
+        animationMode = static_cast<RubiksCube::AnimationMode>(inputLog.GetSettings().animationMode);
+        depthPrepass = inputLog.GetSettings().depthPrepass;
+        bufferStorage = inputLog.GetSettings().bufferStorage;
+        multiDraw = inputLog.GetSettings().multiDraw;
+        wallSize = inputLog.GetSettings().wallSize;
+        lodPixels = inputLog.GetSettings().lodPixels;
+        stickerFiles = inputLog.GetSettings().stickerFiles;
+        proceduralStickers = inputLog.GetSettings().proceduralStickers;
+    }
+    else
+    {
+        InputLog::Settings settings;
+        settings.animationSpeed = animationSpeed;
+        settings.animationMode = animationMode;
+        settings.depthPrepass = depthPrepass;
+        settings.bufferStorage = bufferStorage;
+        settings.multiDraw = multiDraw;
+        settings.wallSize = wallSize;
+        settings.lodPixels = lodPixels;
+        settings.stickerFiles = stickerFiles;
+        settings.proceduralStickers = proceduralStickers;
+        inputLog.SetSettings(settings);
+    }
+
     /* Initialize the library */
     if (!glfwInit())
     {
@@ -421,6 +1055,12 @@ int main(int argc, char* argv[])
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
+    /* Headless replays render into a hidden window */
+    if (headless && replaying)
+    {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
+
     /* Create a windowed mode window and its OpenGL context */
     window = glfwCreateWindow(width, height, "OpenGL", NULL, NULL);
     if (!window)
@@ -432,125 +1072,279 @@ int main(int argc, char* argv[])
     /* Make the window's context current */
     glfwMakeContextCurrent(window);
 
-    /* Load GLAD so it configures OpenGL */
+    /* Load GLAD so it configures OpenGL, then the optional post-3.3 entry points */
     gladLoadGL();
+    GLExtensions::Load((GLADloadproc)glfwGetProcAddress);
+    /* Lets the GL 3.3 fallbacks be compared against the newer paths */
+    GLExtensions::BufferStorage = GLExtensions::BufferStorage && bufferStorage;
+    GLExtensions::MultiDrawIndirect = GLExtensions::MultiDrawIndirect && multiDraw;
 
-    /* Control frame rate */
-    glfwSwapInterval(1);
+    /* Control frame rate (replays run as fast as the machine renders) */
+    glfwSwapInterval(replaying ? 0 : 1);
 
     /* Print OpenGL version after completing initialization */
     std::cout << "OpenGL Version: " << glGetString(GL_VERSION) << std::endl;
 
+    if (checkShaders)
+    {
+        bool ok = CheckShaderPermutations();
+        std::cout << (ok ? "Every shader permutation built" : "Some shader permutations failed to build") << std::endl;
+        glfwTerminate();
+        return ok ? 0 : -1;
+    }
+
     /* Set scope so that on window close the destructors will be called automatically */
     {
         /* Blend to fix images with transperancy */
-        GLCall(glEnable(GL_BLEND));
+        GLStateCache::SetEnabled(GL_BLEND, true);
         GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 
-        /* Generate VAO, VBO, EBO and bind them */
-        VertexArray va;
-        VertexBuffer vb(vertices, sizeof(vertices));
-        IndexBuffer ib(indices, sizeof(indices));
-
-        VertexBufferLayout layout;
-        layout.Push<float>(3);  // positions
-        layout.Push<float>(3);  // colors
-        layout.Push<float>(2);  // texCoords
-        layout.Push<float>(1);  // faceId
-        va.AddBuffer(vb, layout);
+        /* One cubie mesh (VAO, VBO, EBO) shared by every cubie of every puzzle */
+        CubieMesh mesh;
 
-        /* Create texture */
-        Texture texture("res/textures/plane.png");
+        /* Create texture: every sticker style is a layer of one array, streamed in while the first frames draw.
+           A replay waits for it, so every frame it renders is the same on every run.
+           The shader only reads the red channel of the mask, so images are kept as R8; stb_image reduces them
+           to their luminance, which is the same for black and white masks. */
+        AssetLoader assets;
+        Texture texture(stickerFiles, assets, 1);
+        if (replaying)
+        {
+            assets.Finish();
+        }
         texture.Bind();
          
-        /* Create shaders */
-        Shader shader("res/shaders/basic.shader");
+        /* Create shaders: one source, specialized for shading and for id picking, both instanced */
+        Shader shader("res/shaders/basic.shader", { "INSTANCED" });
+        Shader proceduralShader("res/shaders/basic.shader", { "INSTANCED", "PROCEDURAL_STICKER" });
+        Shader pickingShader("res/shaders/basic.shader", { "INSTANCED", "PICKING" });
+        Shader lodShader("res/shaders/basic.shader", { "INSTANCED", "LOD" });
+        if (!shader.IsLinked() || !proceduralShader.IsLinked() || !pickingShader.IsLinked() || !lodShader.IsLinked())
+        {
+            /* Nothing would be drawn. Returning here still runs the destructors while the context is current */
+            std::cout << "Failed to build the shaders in res/shaders/basic.shader" << std::endl;
+            return -1;
+        }
+        lodShader.Bind();
+        lodShader.SetUniform1i("u_Texture", 0);
         shader.Bind();
+        shader.SetUniform1i("u_Texture", 0);
+
+        /* Sticker colors are palette indices; the palette itself lives in a uniform block */
+        const auto& paletteColors = RubiksCube::GetPalette();
+        UniformBuffer palette(paletteColors.data(), sizeof(paletteColors));
+        palette.BindBase(0);
+        shader.SetUniformBlockBinding("Palette", 0);
+        proceduralShader.SetUniformBlockBinding("Palette", 0);
+
+        /* The procedural sticker shape, sized like the one in res/textures/plane.png */
+        StickerShapeBlock stickerShapeBlock;
+        stickerShapeBlock.halfSize = glm::vec2(0.442f);
+        stickerShapeBlock.cornerRadius = 0.11f;
+        UniformBuffer stickerShape(&stickerShapeBlock, sizeof(stickerShapeBlock));
+        stickerShape.BindBase(1);
+        proceduralShader.SetUniformBlockBinding("StickerShape", 1);
+
+        /* Rebuild the shader whenever its source file is saved */
+        if (watchShaders)
+        {
+            shader.EnableHotReload();
+            proceduralShader.EnableHotReload();
+            pickingShader.EnableHotReload();
+            lodShader.EnableHotReload();
+        }
 
-        /* Unbind all to prevent accidentally modifying them */
-        va.Unbind();
-        vb.Unbind();
-        ib.Unbind();
+        /* Unbind to prevent accidentally modifying it */
         shader.Unbind();
 
         /* Enables the Depth Buffer */
-        GLCall(glEnable(GL_DEPTH_TEST));
+        GLStateCache::SetEnabled(GL_DEPTH_TEST, true);
         GLCall(glDepthFunc(GL_LESS));
 
-        /* Create camera */
-        Camera camera(width, height);
-        camera.SetPerspective(45.0f, near, far);
+        /* A single interactive puzzle, or a wall of puzzles each replaying its own scramble and solve */
+        CubeScene scene(wallSize > 0 ? wallSize : 1, 1.06f);
+        scene.SetAnimationSpeed(animationSpeed);
+        scene.SetAnimationMode(animationMode);
+        RubiksCube& rubiks = scene.GetPuzzle(0);
+        if (wallSize > 0)
+        {
+            scene.EnableAutoplay(1);
+        }
 
-        RubiksCube rubiks(1.06f);
-        rubiks.Initialize();
+        /* Sticker images of every puzzle, for drawing the distant ones as a single box */
+        StickerAtlas atlas(scene.GetPuzzleCount());
+
+        /* Create camera, pulled back far enough to see the whole wall */
+        Camera camera(width, height);
+        float farPlane = far;
+        if (wallSize > 0)
+        {
+            float distance = 1.2f * scene.GetExtent() / std::tan(glm::radians(22.5f));
+            farPlane = std::max(far, 2.0f * distance);
+            camera.SetDistance(distance, 2.0f, farPlane * 0.5f);
+        }
+        camera.SetPerspective(45.0f, near, farPlane);
+
+        /* Sorts and batches the cubie draws of a frame into instanced draws */
+        Renderer renderer;
+
+        RenderContext renderContext;
+        renderContext.shader = &shader;
+        renderContext.pickingShader = &pickingShader;
+        renderContext.lodShader = &lodShader;
+        renderContext.proceduralShader = &proceduralShader;
+        renderContext.mesh = &mesh;
+        renderContext.atlas = &atlas;
+        renderContext.texture = &texture;
+        renderContext.assets = &assets;
+        renderContext.palette = &palette;
+        renderContext.renderer = &renderer;
+
+        RenderThreadShared renderShared;
+        renderShared.scene = &scene;
 
         AppState appState;
         appState.camera = &camera;
+        appState.scene = &scene;
         appState.rubiks = &rubiks;
-        appState.shader = &shader;
-        appState.va = &va;
-        appState.ib = &ib;
-        appState.texture = &texture;
+        appState.render = &renderContext;
+        renderContext.stickerStyleCount = &appState.stickerStyleCount;
+        appState.pickMailbox = renderThread ? &renderShared.pick : nullptr;
+        appState.recorder = recordPath.empty() ? nullptr : &inputLog;
+        appState.replaying = replaying;
+        appState.depthPrepass = depthPrepass;
+        appState.lodPixels = lodPixels;
+        appState.proceduralStickers = proceduralStickers;
+        appState.wall = wallSize > 0;
+        appState.farPlane = farPlane;
 
         glfwSetWindowUserPointer(window, &appState);
         glfwSetKeyCallback(window, KeyCallback);
         glfwSetMouseButtonCallback(window, MouseButtonCallback);
         glfwSetCursorPosCallback(window, CursorPosCallback);
         glfwSetScrollCallback(window, ScrollCallback);
+        glfwSetWindowSizeCallback(window, WindowSizeCallback);
         glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
 
+        /* The starting size goes through the callbacks too, so it opens the log; a replay takes it from there */
+        int startWidth = 0;
+        int startHeight = 0;
+        glfwGetWindowSize(window, &startWidth, &startHeight);
+        appState.windowSize = glm::ivec2(startWidth, startHeight);
+        WindowSizeCallback(window, startWidth, startHeight);
+        glfwGetFramebufferSize(window, &startWidth, &startHeight);
+        appState.framebufferSize = glm::ivec2(startWidth, startHeight);
+        FramebufferSizeCallback(window, startWidth, startHeight);
+
+        /* Simulate at a fixed rate, independent of the render rate */
+        FixedTimestep timestep(1.0 / 120.0);
+        Profiler profiler;
+        ViewSnapshot viewSnapshot;
         double lastTime = glfwGetTime();
+        GLStateCache::ResetCounters();
+        renderer.ResetStats();
+
+        /* Hand the GL context to a dedicated render thread that draws the latest published snapshot */
+        std::thread renderWorker;
+        if (renderThread)
+        {
+            BuildViewSnapshot(&appState, renderShared.views.GetWriteBuffer());
+            renderShared.views.Publish();
+            scene.PublishSnapshots();
+            glfwMakeContextCurrent(nullptr);
+            renderWorker = std::thread(RenderThreadMain, window, &renderContext, &renderShared);
+        }
 
         /* Loop until the user closes the window */
         while (!glfwWindowShouldClose(window))
         {
             double currentTime = glfwGetTime();
-            float deltaTime = static_cast<float>(currentTime - lastTime);
-            lastTime = currentTime;
-
-            rubiks.Update(deltaTime);
+            profiler.BeginFrame(currentTime);
 
-            /* Set white background color */
-            GLCall(glClearColor(0.05f, 0.05f, 0.05f, 1.0f));
+            float alpha = 1.0f;
+            if (replaying)
+            {
+                /* One simulation step per frame, feeding the events recorded up to this tick */
+                InputEvent event;
+                while (inputLog.Next(appState.tick, event))
+                {
+                    DispatchInputEvent(window, &appState, event);
+                }
+                scene.Update(timestep.GetStepSeconds());
+                appState.tick++;
 
-            /* Render here */
-            GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+                /* A wall never settles, so it replays until every puzzle has finished one solve */
+                bool settled = appState.wall ? scene.GetMinSolveCount() > 0 : scene.IsIdle();
+                if (inputLog.IsFinished() && settled)
+                {
+                    glfwSetWindowShouldClose(window, GLFW_TRUE);
+                }
+            }
+            else
+            {
+                int steps = timestep.Advance(currentTime - lastTime);
+                for (int i = 0; i < steps; ++i)
+                {
+                    scene.Update(timestep.GetStepSeconds());
+                }
+                appState.tick = timestep.GetTickCount();
+                alpha = timestep.GetAlpha();
+            }
+            lastTime = currentTime;
 
-            glm::mat4 view = camera.GetViewMatrix();
-            glm::mat4 proj = camera.GetProjectionMatrix();
+            /* Publish once per frame after the simulation steps */
+            scene.PublishSnapshots(alpha);
 
-            shader.Bind();
-            shader.SetUniform1i("u_Picking", 0);
-            shader.SetUniform1i("u_Texture", 0);
+            if (renderThread)
+            {
+                BuildViewSnapshot(&appState, renderShared.views.GetWriteBuffer());
+                renderShared.views.Publish();
+                ApplyPickResult(&appState);
 
-            va.Bind();
-            ib.Bind();
-            texture.Bind();
+                /* Sleep until the next simulation step unless input arrives first */
+                glfwWaitEventsTimeout(timestep.GetStepSeconds());
+            }
+            else
+            {
+                BuildViewSnapshot(&appState, viewSnapshot);
+                scene.AcquireSnapshots();
+                ReloadShaders(renderContext);
+                assets.Update();
+                RenderFrame(renderContext, viewSnapshot, scene);
 
-            glm::vec4 color = glm::vec4(1.0f);
-            shader.SetUniform4f("u_Color", color);
+                /* Swap front and back buffers */
+                glfwSwapBuffers(window);
 
-            for (const auto& cube : rubiks.GetCubes())
-            {
-                const glm::vec3* faceColors = rubiks.GetCubeFaceColors(cube.id);
-                if (faceColors)
-                {
-                    for (int i = 0; i < 6; ++i)
-                    {
-                        shader.SetUniform3f("u_FaceColors[" + std::to_string(i) + "]", faceColors[i]);
-                    }
-                }
-                glm::mat4 model = rubiks.GetCubeModel(cube.id);
-                glm::mat4 mvp = proj * view * model;
-                shader.SetUniformMat4f("u_MVP", mvp);
-                GLCall(glDrawElements(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr));
+                /* Poll for and process events */
+                glfwPollEvents();
             }
 
-            /* Swap front and back buffers */
-            glfwSwapBuffers(window);
+            profiler.EndFrame(glfwGetTime());
+        }
 
-            /* Poll for and process events */
-            glfwPollEvents();
+        if (renderWorker.joinable())
+        {
+            renderShared.quit.store(true);
+            renderWorker.join();
+            glfwMakeContextCurrent(window);
+        }
+
+        if (replaying)
+        {
+            std::cout << "Replay of " << replayPath << " (" << inputLog.GetEventCount() << " events, "
+                << appState.tick << " ticks)" << std::endl;
+            GLStateCache::Counters glState = GLStateCache::GetCounters();
+            profiler.AddCount("GL state changes issued", glState.issued);
+            profiler.AddCount("GL state changes skipped", glState.skipped);
+            profiler.AddCount("Draw commands", renderer.GetStats().commands);
+            profiler.AddCount("Draw calls", renderer.GetStats().drawCalls);
+            profiler.AddCount("Sticker tiles baked", atlas.GetBakeCount());
+            profiler.AddCount("Texture bytes uploaded", assets.GetUploadedBytes());
+            profiler.Report(std::cout);
+        }
+        if (!recordPath.empty() && inputLog.Save(recordPath))
+        {
+            std::cout << "Recorded " << inputLog.GetEventCount() << " input events to " << recordPath << std::endl;
         }
     }
 
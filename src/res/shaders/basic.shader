@@ -1,23 +1,81 @@
 #shader vertex
 #version 330
 
+// Variants: PICKING (id color only), INSTANCED (per-instance model and palette),
+// LOD (whole puzzle as one box textured from StickerAtlas, the palette attribute holds the atlas tile)
+// PROCEDURAL_STICKER (sticker shape from the StickerShape block instead of the mask texture)
+
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 color;
 layout(location = 2) in vec2 texCoord;
 layout(location = 3) in float faceId;
 
-out vec4 v_Color;
-out vec2 v_TexCoord;
-flat out int v_FaceId;
+#ifdef INSTANCED
+layout(location = 4) in mat4 a_Model;
+layout(location = 8) in uint a_FacePalette;
+layout(location = 9) in uint a_PickId;
+layout(location = 10) in uint a_Style;
 
+uniform mat4 u_ViewProjection;
+#else
 uniform mat4 u_MVP;
+uniform uint u_FacePalette;
+uniform uint u_PickId;
+uniform uint u_Style;
+#endif
+
+#ifdef PICKING
+flat out uint v_PickId;
+#elif defined(LOD)
+uniform sampler2D u_Texture;
+
+out vec2 v_TexCoord;
+
+// Must match StickerAtlas: a tile per puzzle, its six faces side by side
+const float FaceTexels = 24.0;
+
+vec2 AtlasTexCoord(uint tile, float faceId, vec2 texCoord)
+{
+	vec2 atlasSize = vec2(textureSize(u_Texture, 0));
+	uint columns = uint(atlasSize.x / (6.0 * FaceTexels));
+	vec2 tileOrigin = vec2(float(tile % columns) * 6.0, float(tile / columns)) * FaceTexels;
+	vec2 texel = tileOrigin + (vec2(floor(faceId + 0.5), 0.0) + texCoord) * FaceTexels;
+	return texel / atlasSize;
+}
+#else
+#include "palette.glsl"
+
+out vec2 v_TexCoord;
+flat out uint v_PaletteIndex;
+flat out uint v_Style;
+#endif
+
+// The depth prepass and the shading pass must produce bit-identical depth
+invariant gl_Position;
 
 void main()
 {
-	gl_Position = u_MVP *  vec4(position.x, position.y, position.z, 1.0);
-	v_Color = vec4(color.x, color.y, color.z, 1.0);
+#ifdef INSTANCED
+	gl_Position = u_ViewProjection * a_Model * vec4(position, 1.0);
+	uint facePalette = a_FacePalette;
+	uint pickId = a_PickId;
+	uint style = a_Style;
+#else
+	gl_Position = u_MVP * vec4(position, 1.0);
+	uint facePalette = u_FacePalette;
+	uint pickId = u_PickId;
+	uint style = u_Style;
+#endif
+
+#ifdef PICKING
+	v_PickId = pickId;
+#elif defined(LOD)
+	v_TexCoord = AtlasTexCoord(facePalette, faceId, texCoord);
+#else
 	v_TexCoord = texCoord;
-	v_FaceId = int(faceId + 0.5);
+	v_PaletteIndex = FacePaletteIndex(facePalette, faceId);
+	v_Style = style;
+#endif
 }
 
 #shader fragment
@@ -25,26 +83,46 @@ void main()
 
 layout(location = 0) out vec4 FragColor;
 
-in vec4 v_Color;
+#ifdef PICKING
+#include "picking.glsl"
+
+flat in uint v_PickId;
+
+void main()
+{
+	FragColor = EncodePickId(v_PickId);
+}
+#elif defined(LOD)
 in vec2 v_TexCoord;
-flat in int v_FaceId;
 
-uniform vec4 u_Color;
 uniform sampler2D u_Texture;
-uniform int u_Picking;
-uniform vec3 u_FaceColors[6];
 
 void main()
 {
-	if (u_Picking == 1)
-	{
-		FragColor = u_Color;
-	}
-	else
-	{
-		float mask = texture(u_Texture, v_TexCoord).r;
-		vec3 sticker = u_FaceColors[v_FaceId];
-		vec3 finalColor = mix(vec3(0.0f), sticker, mask);
-		FragColor = vec4(finalColor, 1.0f);
-	}
+	FragColor = vec4(texture(u_Texture, v_TexCoord).rgb, 1.0f);
+}
+#else
+#include "palette.glsl"
+
+in vec2 v_TexCoord;
+flat in uint v_PaletteIndex;
+flat in uint v_Style;
+
+#ifdef PROCEDURAL_STICKER
+#include "sticker.glsl"
+#else
+// One sticker style per layer
+uniform sampler2DArray u_Texture;
+#endif
+
+void main()
+{
+#ifdef PROCEDURAL_STICKER
+	float mask = StickerMask(v_TexCoord);
+#else
+	float mask = texture(u_Texture, vec3(v_TexCoord, float(v_Style))).r;
+#endif
+	vec3 sticker = u_PaletteColors[v_PaletteIndex].rgb;
+	FragColor = vec4(mix(vec3(0.0f), sticker, mask), 1.0f);
 }
+#endif
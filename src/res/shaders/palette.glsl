@@ -0,0 +1,11 @@
+// Sticker colors, indexed by the 3-bit per-face entries of a packed face palette
+layout(std140) uniform Palette
+{
+	vec4 u_PaletteColors[8];
+};
+
+// Face i of a cubie uses bits [3i, 3i+3) of its packed palette
+uint FacePaletteIndex(uint facePalette, float faceId)
+{
+	return (facePalette >> (3u * uint(faceId + 0.5))) & 7u;
+}
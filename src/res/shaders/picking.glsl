@@ -0,0 +1,6 @@
+// Cubie id + 1 spread over the RGB bytes, 0 is left for the background
+vec4 EncodePickId(uint id)
+{
+	uint index = id + 1u;
+	return vec4(float(index & 255u), float((index >> 8) & 255u), float((index >> 16) & 255u), 255.0) / 255.0;
+}
@@ -0,0 +1,15 @@
+// Analytic sticker shape: a rounded rectangle centered on the face, in texture coordinates
+layout(std140) uniform StickerShape
+{
+	vec2 u_StickerHalfSize;
+	float u_StickerCornerRadius;
+};
+
+// Coverage of the sticker at texCoord, antialiased over about one pixel at any distance
+float StickerMask(vec2 texCoord)
+{
+	vec2 p = abs(texCoord - vec2(0.5)) - (u_StickerHalfSize - vec2(u_StickerCornerRadius));
+	float distance = length(max(p, vec2(0.0))) + min(max(p.x, p.y), 0.0) - u_StickerCornerRadius;
+	float pixel = max(fwidth(distance), 1e-5);
+	return clamp(0.5 - distance / pixel, 0.0, 1.0);
+}